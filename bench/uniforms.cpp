@@ -0,0 +1,119 @@
+//===-- Uniform set benchmark for derp ------------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "derp/shader.hpp"
+
+#include <chrono>        // std::chrono::steady_clock
+#include <functional>    // std::hash, std::equal_to
+#include <print>         // std::println
+#include <string>        // std::string
+#include <string_view>   // std::string_view
+#include <unordered_map> // std::unordered_map
+
+#include <glad/glad.h>
+
+#include <GLFW/glfw3.h>
+
+// uniform sets per second: straight to GL through the string keyed map
+// shader used to look locations up in, then through the uniform shadow,
+// flushed after every set as a draw would, by compile time hashed name, by
+// cached typed handle, and with a value that doesn't change
+
+namespace {
+
+constexpr int SETS = 1'000'000;
+
+struct string_view_hash {
+  using is_transparent = void;
+  auto operator()(const std::string_view sv) const noexcept -> std::size_t {
+    return std::hash<std::string_view>{}(sv);
+  }
+};
+
+template <typename F> auto rate(const char *what, F &&set) -> void {
+  glFinish();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < SETS; ++i)
+    set(static_cast<float>(i));
+  glFinish();
+  const std::chrono::duration<double> took =
+      std::chrono::steady_clock::now() - start;
+  std::println("[INFO] {:<12} {:>8.2f} M sets/s", what,
+               SETS / took.count() / 1e6);
+}
+
+} // namespace
+
+int main() {
+  if (!glfwInit()) {
+    std::println("[ERROR] Couldn't initialize GLFW.");
+    return -1;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+  GLFWwindow *window = glfwCreateWindow(64, 64, "derp bench", nullptr, nullptr);
+  if (!window) {
+    glfwTerminate();
+    std::println("[ERROR] Couldn't create GLFW window.");
+    return -1;
+  }
+  glfwMakeContextCurrent(window);
+  if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+    std::println("[ERROR] Couldn't initialize GLAD.");
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return -1;
+  }
+
+  {
+    derp::shader s(RESOURCES_PATH "/shaders/light_cube.vert",
+                   RESOURCES_PATH "/shaders/light_cube.frag");
+    s.use();
+
+    std::unordered_map<std::string, int, string_view_hash, std::equal_to<>>
+        locations;
+    rate("string map", [&](const float f) {
+      const std::string_view name = "u_model";
+      auto it = locations.find(name);
+      if (it == locations.end())
+        it = locations
+                 .emplace(std::string(name),
+                          s.get_reflection()
+                              .find_uniform(derp::fnv1a(name))
+                              ->location)
+                 .first;
+      int current = 0;
+      glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+      derp::set_uniform(static_cast<uint32_t>(current), it->second,
+                        glm::mat4(f));
+    });
+
+    rate("hashed name", [&](const float f) {
+      s["u_model"] = glm::mat4(f);
+      derp::uniform_shadow::flush_all();
+    });
+
+    const auto model = s.handle<glm::mat4>("u_model");
+    rate("handle", [&](const float f) {
+      model = glm::mat4(f);
+      derp::uniform_shadow::flush_all();
+    });
+    rate("unchanged", [&](float) {
+      model = glm::mat4(1.0f);
+      derp::uniform_shadow::flush_all();
+    });
+  }
+
+  glfwDestroyWindow(window);
+  glfwTerminate();
+  return 0;
+}
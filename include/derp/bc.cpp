@@ -0,0 +1,545 @@
+//===-- Implementation of block compression -------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "bc.hpp"
+
+#include <algorithm> // std::min, std::max, std::clamp, std::swap
+#include <array>     // std::array
+#include <cmath>     // std::lround, std::sqrt, std::abs
+#include <cstring>   // std::memcpy
+#include <limits>    // std::numeric_limits
+
+namespace derp {
+
+namespace {
+
+using texel = std::array<float, 4>;
+using block = std::array<texel, 16>;
+using channel_block = std::array<float, 16>;
+
+// gathers a 4x4 block as RGBA, clamping at the level's edges. grey images
+// replicate into RGB, missing alpha is opaque.
+auto fetch(const image::level &level, const int channels, const int bx,
+           const int by) -> block {
+  block px{};
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      const int sx = std::min(bx * 4 + x, level.width - 1);
+      const int sy = std::min(by * 4 + y, level.height - 1);
+      const unsigned char *src =
+          level.pixels.get() +
+          (static_cast<std::size_t>(sy) * level.width + sx) * channels;
+
+      const auto c = [src](const int i) { return static_cast<float>(src[i]); };
+      auto &p = px[y * 4 + x];
+      switch (channels) {
+      case 1:
+        p = {c(0), c(0), c(0), 255.0f};
+        break;
+      case 2:
+        p = {c(0), c(0), c(0), c(1)};
+        break;
+      case 3:
+        p = {c(0), c(1), c(2), 255.0f};
+        break;
+      default:
+        p = {c(0), c(1), c(2), c(3)};
+        break;
+      }
+    }
+  }
+  return px;
+}
+
+// one raw channel of a 4x4 block, for BC4/BC5
+auto fetch_channel(const image::level &level, const int channels, int channel,
+                   const int bx, const int by) -> channel_block {
+  channel = std::min(channel, channels - 1);
+  channel_block values{};
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      const int sx = std::min(bx * 4 + x, level.width - 1);
+      const int sy = std::min(by * 4 + y, level.height - 1);
+      values[y * 4 + x] =
+          level.pixels.get()[(static_cast<std::size_t>(sy) * level.width +
+                              sx) *
+                                 channels +
+                             channel];
+    }
+  }
+  return values;
+}
+
+// endpoint fitting over the first `dims` channels. e0 and e1 are the ends of
+// the line the palette is interpolated on.
+struct endpoints {
+  texel e0{};
+  texel e1{};
+};
+
+auto fit_bounding_box(const block &px, const int dims) -> endpoints {
+  texel lo{255.0f, 255.0f, 255.0f, 255.0f};
+  texel hi{0.0f, 0.0f, 0.0f, 0.0f};
+  texel mean{};
+  for (const auto &p : px) {
+    for (int c = 0; c < dims; ++c) {
+      lo[c] = std::min(lo[c], p[c]);
+      hi[c] = std::max(hi[c], p[c]);
+      mean[c] += p[c] / 16.0f;
+    }
+  }
+
+  // the box diagonal runs the wrong way for channels that fall while the
+  // first one rises, flip those
+  for (int c = 1; c < dims; ++c) {
+    float covariance = 0.0f;
+    for (const auto &p : px)
+      covariance += (p[0] - mean[0]) * (p[c] - mean[c]);
+    if (covariance < 0.0f)
+      std::swap(lo[c], hi[c]);
+  }
+
+  // pull the ends in a little, the extremes are rarely hit exactly
+  endpoints e;
+  for (int c = 0; c < dims; ++c) {
+    const float inset = (hi[c] - lo[c]) / 16.0f;
+    e.e0[c] = hi[c] - inset;
+    e.e1[c] = lo[c] + inset;
+  }
+  return e;
+}
+
+auto fit_principal_axis(const block &px, const int dims) -> endpoints {
+  texel mean{};
+  for (const auto &p : px)
+    for (int c = 0; c < dims; ++c)
+      mean[c] += p[c] / 16.0f;
+
+  std::array<std::array<float, 4>, 4> cov{};
+  for (const auto &p : px)
+    for (int i = 0; i < dims; ++i)
+      for (int j = 0; j < dims; ++j)
+        cov[i][j] += (p[i] - mean[i]) * (p[j] - mean[j]);
+
+  // power iteration from the box diagonal
+  const auto box = fit_bounding_box(px, dims);
+  texel axis{};
+  for (int c = 0; c < dims; ++c)
+    axis[c] = box.e0[c] - box.e1[c];
+
+  for (int iteration = 0; iteration < 8; ++iteration) {
+    texel next{};
+    float length = 0.0f;
+    for (int i = 0; i < dims; ++i) {
+      for (int j = 0; j < dims; ++j)
+        next[i] += cov[i][j] * axis[j];
+      length += next[i] * next[i];
+    }
+    if (length < 1e-12f)
+      return box; // flat block
+    length = std::sqrt(length);
+    for (int c = 0; c < dims; ++c)
+      axis[c] = next[c] / length;
+  }
+
+  float t_min = std::numeric_limits<float>::max();
+  float t_max = std::numeric_limits<float>::lowest();
+  for (const auto &p : px) {
+    float t = 0.0f;
+    for (int c = 0; c < dims; ++c)
+      t += (p[c] - mean[c]) * axis[c];
+    t_min = std::min(t_min, t);
+    t_max = std::max(t_max, t);
+  }
+
+  endpoints e;
+  for (int c = 0; c < dims; ++c) {
+    e.e0[c] = std::clamp(mean[c] + axis[c] * t_max, 0.0f, 255.0f);
+    e.e1[c] = std::clamp(mean[c] + axis[c] * t_min, 0.0f, 255.0f);
+  }
+  return e;
+}
+
+auto fit(const block &px, const int dims, const texture_quality quality)
+    -> endpoints {
+  return quality == texture_quality::HIGH ? fit_principal_axis(px, dims)
+                                          : fit_bounding_box(px, dims);
+}
+
+// least squares endpoints for fixed indices. weights[i] is how far palette
+// entry i sits from e0 towards e1.
+template <std::size_t N>
+auto refine(const block &px, const int dims,
+            const std::array<uint8_t, 16> &indices,
+            const std::array<float, N> &weights, endpoints &e) -> bool {
+  float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+  texel ax{}, bx{};
+  for (int i = 0; i < 16; ++i) {
+    const float w = weights[indices[i]];
+    const float a = 1.0f - w;
+    aa += a * a;
+    ab += a * w;
+    bb += w * w;
+    for (int c = 0; c < dims; ++c) {
+      ax[c] += a * px[i][c];
+      bx[c] += w * px[i][c];
+    }
+  }
+
+  const float det = aa * bb - ab * ab;
+  if (std::abs(det) < 1e-6f)
+    return false;
+
+  for (int c = 0; c < dims; ++c) {
+    e.e0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / det, 0.0f, 255.0f);
+    e.e1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / det, 0.0f, 255.0f);
+  }
+  return true;
+}
+
+template <std::size_t N>
+auto pick_indices(const block &px, const int dims,
+                  const std::array<texel, N> &palette,
+                  std::array<uint8_t, 16> &indices) -> float {
+  float total = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    float best = std::numeric_limits<float>::max();
+    for (std::size_t k = 0; k < N; ++k) {
+      float d = 0.0f;
+      for (int c = 0; c < dims; ++c) {
+        const float diff = px[i][c] - palette[k][c];
+        d += diff * diff;
+      }
+      if (d < best) {
+        best = d;
+        indices[i] = static_cast<uint8_t>(k);
+      }
+    }
+    total += best;
+  }
+  return total;
+}
+
+//===-- BC1 ---------------------------------------------------------------===//
+
+auto to_565(const texel &c) -> uint16_t {
+  const auto q = [](const float v, const int max) {
+    return static_cast<uint16_t>(
+        std::clamp(std::lround(v * max / 255.0f), 0l, static_cast<long>(max)));
+  };
+  return static_cast<uint16_t>(q(c[0], 31) << 11 | q(c[1], 63) << 5 |
+                               q(c[2], 31));
+}
+
+auto from_565(const uint16_t c) -> texel {
+  const int r = c >> 11 & 31;
+  const int g = c >> 5 & 63;
+  const int b = c & 31;
+  return {static_cast<float>(r << 3 | r >> 2),
+          static_cast<float>(g << 2 | g >> 4),
+          static_cast<float>(b << 3 | b >> 2), 255.0f};
+}
+
+struct bc1_result {
+  uint64_t bits = 0;
+  float error = std::numeric_limits<float>::max();
+  std::array<uint8_t, 16> indices{};
+};
+
+auto encode_bc1_endpoints(const block &px, const endpoints &e) -> bc1_result {
+  uint16_t c0 = to_565(e.e0);
+  uint16_t c1 = to_565(e.e1);
+  if (c0 < c1)
+    std::swap(c0, c1); // 4 colour mode needs c0 > c1
+
+  const texel p0 = from_565(c0);
+  const texel p1 = from_565(c1);
+  std::array<texel, 4> palette{p0, p1};
+  for (int c = 0; c < 3; ++c) {
+    palette[2][c] = (2.0f * p0[c] + p1[c]) / 3.0f;
+    palette[3][c] = (p0[c] + 2.0f * p1[c]) / 3.0f;
+  }
+
+  bc1_result r;
+  if (c0 == c1) {
+    // 3 colour mode, index 0 is still c0
+    r.error = pick_indices(px, 3, std::array<texel, 1>{p0}, r.indices);
+  } else {
+    r.error = pick_indices(px, 3, palette, r.indices);
+  }
+
+  r.bits = static_cast<uint64_t>(c0) | static_cast<uint64_t>(c1) << 16;
+  for (int i = 0; i < 16; ++i)
+    r.bits |= static_cast<uint64_t>(r.indices[i]) << (32 + 2 * i);
+  return r;
+}
+
+auto encode_bc1(const block &px, const texture_quality quality) -> uint64_t {
+  auto e = fit(px, 3, quality);
+  auto best = encode_bc1_endpoints(px, e);
+
+  if (quality == texture_quality::HIGH) {
+    constexpr std::array<float, 4> weights{0.0f, 1.0f, 1.0f / 3.0f,
+                                           2.0f / 3.0f};
+    if (refine(px, 3, best.indices, weights, e)) {
+      if (auto r = encode_bc1_endpoints(px, e); r.error < best.error)
+        best = r;
+    }
+  }
+  return best.bits;
+}
+
+//===-- BC4 ---------------------------------------------------------------===//
+
+auto encode_bc4(const channel_block &values, const texture_quality quality)
+    -> uint64_t {
+  block px{};
+  float lo = 255.0f, hi = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    px[i][0] = values[i];
+    lo = std::min(lo, values[i]);
+    hi = std::max(hi, values[i]);
+  }
+
+  const auto encode = [&](const float e0, const float e1,
+                          std::array<uint8_t, 16> &indices,
+                          float &error) -> uint64_t {
+    const auto r0 = static_cast<uint8_t>(std::lround(e0));
+    const auto r1 = static_cast<uint8_t>(std::lround(e1));
+    std::array<texel, 8> palette{};
+    palette[0][0] = r0;
+    palette[1][0] = r1;
+    for (int i = 2; i < 8; ++i)
+      palette[i][0] = ((8.0f - i) * r0 + (i - 1.0f) * r1) / 7.0f;
+
+    uint64_t bits = static_cast<uint64_t>(r0) | static_cast<uint64_t>(r1) << 8;
+    if (r0 <= r1) {
+      // only r0 > r1 selects the 8 value mode, equal ends mean a flat block
+      indices.fill(0);
+      error = 0.0f;
+      for (const float v : values)
+        error += (v - r0) * (v - r0);
+      return bits;
+    }
+
+    error = pick_indices(px, 1, palette, indices);
+    for (int i = 0; i < 16; ++i)
+      bits |= static_cast<uint64_t>(indices[i]) << (16 + 3 * i);
+    return bits;
+  };
+
+  std::array<uint8_t, 16> indices{};
+  float error = 0.0f;
+  uint64_t best = encode(hi, lo, indices, error);
+
+  if (quality == texture_quality::HIGH && hi > lo) {
+    constexpr std::array<float, 8> weights{
+        0.0f, 1.0f, 1.0f / 7, 2.0f / 7, 3.0f / 7, 4.0f / 7, 5.0f / 7, 6.0f / 7};
+    endpoints e;
+    if (refine(px, 1, indices, weights, e) && e.e0[0] > e.e1[0]) {
+      std::array<uint8_t, 16> refined{};
+      float refined_error = 0.0f;
+      const uint64_t bits = encode(e.e0[0], e.e1[0], refined, refined_error);
+      if (refined_error < error)
+        best = bits;
+    }
+  }
+  return best;
+}
+
+//===-- BC7 ---------------------------------------------------------------===//
+
+struct bit_writer {
+  std::array<uint64_t, 2> words{};
+  uint32_t position = 0;
+
+  auto put(const uint64_t value, const uint32_t count) -> void {
+    for (uint32_t i = 0; i < count; ++i, ++position) {
+      words[position / 64] |= (value >> i & 1) << (position % 64);
+    }
+  }
+};
+
+struct bc7_result {
+  std::array<uint64_t, 2> words{};
+  float error = std::numeric_limits<float>::max();
+  std::array<uint8_t, 16> indices{};
+};
+
+// mode 6: one subset, RGBA 7 bit endpoints plus a p-bit each, 4 bit indices
+auto encode_bc7_endpoints(const block &px, const endpoints &e) -> bc7_result {
+  constexpr std::array<int, 16> weights{0,  4,  9,  13, 17, 21, 26, 30,
+                                        34, 38, 43, 47, 51, 55, 60, 64};
+
+  struct quantized {
+    std::array<int, 4> q{};
+    int p = 0;
+  };
+
+  const auto quantize = [](const texel &v) {
+    quantized best;
+    float best_error = std::numeric_limits<float>::max();
+    for (int p = 0; p < 2; ++p) {
+      quantized candidate{.p = p};
+      float error = 0.0f;
+      for (int c = 0; c < 4; ++c) {
+        candidate.q[c] = std::clamp(
+            static_cast<int>(std::lround((v[c] - p) / 2.0f)), 0, 127);
+        const float d = static_cast<float>(candidate.q[c] << 1 | p) - v[c];
+        error += d * d;
+      }
+      if (error < best_error) {
+        best_error = error;
+        best = candidate;
+      }
+    }
+    return best;
+  };
+
+  quantized q0 = quantize(e.e0);
+  quantized q1 = quantize(e.e1);
+
+  std::array<texel, 16> palette{};
+  for (int k = 0; k < 16; ++k) {
+    for (int c = 0; c < 4; ++c) {
+      const int a = q0.q[c] << 1 | q0.p;
+      const int b = q1.q[c] << 1 | q1.p;
+      palette[k][c] = static_cast<float>(
+          ((64 - weights[k]) * a + weights[k] * b + 32) >> 6);
+    }
+  }
+
+  bc7_result r;
+  r.error = pick_indices(px, 4, palette, r.indices);
+
+  // the anchor index is stored without its top bit, so it has to be < 8
+  auto stored = r.indices;
+  if (stored[0] >= 8) {
+    std::swap(q0, q1);
+    for (auto &i : stored)
+      i = static_cast<uint8_t>(15 - i);
+  }
+
+  bit_writer w;
+  w.put(1 << 6, 7); // mode 6
+  for (int c = 0; c < 4; ++c) {
+    w.put(q0.q[c], 7);
+    w.put(q1.q[c], 7);
+  }
+  w.put(q0.p, 1);
+  w.put(q1.p, 1);
+  w.put(stored[0], 3);
+  for (int i = 1; i < 16; ++i)
+    w.put(stored[i], 4);
+
+  r.words = w.words;
+  return r;
+}
+
+auto encode_bc7(const block &px, const texture_quality quality)
+    -> std::array<uint64_t, 2> {
+  auto e = fit(px, 4, quality);
+  auto best = encode_bc7_endpoints(px, e);
+
+  if (quality == texture_quality::HIGH) {
+    std::array<float, 16> weights{};
+    for (int k = 0; k < 16; ++k)
+      weights[k] = static_cast<float>(std::lround(k * 64.0f / 15.0f)) / 64.0f;
+    if (refine(px, 4, best.indices, weights, e)) {
+      if (auto r = encode_bc7_endpoints(px, e); r.error < best.error)
+        best = r;
+    }
+  }
+  return best.words;
+}
+
+//===----------------------------------------------------------------------===//
+
+auto encode_block(const image::level &level, const int channels,
+                  const block_format format, const texture_quality quality,
+                  const int bx, const int by, unsigned char *dst) -> void {
+  const auto store = [&dst](const uint64_t bits) {
+    std::memcpy(dst, &bits, sizeof(bits)); // little endian, as BCn expects
+    dst += sizeof(bits);
+  };
+
+  switch (format) {
+  case block_format::BC1:
+    store(encode_bc1(fetch(level, channels, bx, by), quality));
+    break;
+  case block_format::BC3: {
+    const auto px = fetch(level, channels, bx, by);
+    channel_block alpha{};
+    for (int i = 0; i < 16; ++i)
+      alpha[i] = px[i][3];
+    store(encode_bc4(alpha, quality));
+    store(encode_bc1(px, quality));
+    break;
+  }
+  case block_format::BC4:
+    store(encode_bc4(fetch_channel(level, channels, 0, bx, by), quality));
+    break;
+  case block_format::BC5:
+    store(encode_bc4(fetch_channel(level, channels, 0, bx, by), quality));
+    store(encode_bc4(fetch_channel(level, channels, 1, bx, by), quality));
+    break;
+  case block_format::BC7: {
+    const auto words = encode_bc7(fetch(level, channels, bx, by), quality);
+    store(words[0]);
+    store(words[1]);
+    break;
+  }
+  default:
+    break;
+  }
+}
+
+auto decoded_channels(const block_format format) -> int {
+  switch (format) {
+  case block_format::BC1:
+    return 3;
+  case block_format::BC4:
+    return 1;
+  case block_format::BC5:
+    return 2;
+  default:
+    return 4;
+  }
+}
+
+} // namespace
+
+auto compress(image &img, const block_format format,
+              const texture_quality quality, thread_pool &pool) -> void {
+  if (img.block != block_format::NONE || format == block_format::NONE)
+    return;
+
+  const auto bytes = block_bytes(format);
+  for (auto &level : img.levels) {
+    auto out = make_level(level.width, level.height, img.channels, format);
+    const int blocks_x = (level.width + 3) / 4;
+    const auto blocks_y = static_cast<uint32_t>((level.height + 3) / 4);
+
+    pool.parallel_for(blocks_y, [&](const uint32_t by) {
+      for (int bx = 0; bx < blocks_x; ++bx) {
+        auto *dst = out.pixels.get() +
+                    (static_cast<std::size_t>(by) * blocks_x + bx) * bytes;
+        encode_block(level, img.channels, format, quality, bx,
+                     static_cast<int>(by), dst);
+      }
+    });
+
+    level = std::move(out);
+  }
+
+  img.block = format;
+  img.channels = decoded_channels(format);
+}
+
+} // namespace derp
@@ -0,0 +1,28 @@
+//===-- Implementation header for block compression -----------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+namespace derp {
+
+// FAST fits endpoints to the bounding box of each block, HIGH fits them to
+// the principal axis and refines them with a least squares pass.
+enum class texture_quality { FAST, HIGH };
+
+// CPU encoder for BC1 (opaque colour), BC3 (colour + alpha), BC4 (one
+// channel), BC5 (two channels, normal maps) and BC7 (colour + alpha, mode 6
+// only). compresses every level of an uncompressed 8 bit image in place,
+// block rows are spread over the pool's workers and the calling thread.
+auto compress(image &img, block_format format, texture_quality quality,
+              thread_pool &pool) -> void;
+
+} // namespace derp
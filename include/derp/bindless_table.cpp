@@ -0,0 +1,123 @@
+//===-- Implementation of bindless table class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "bindless_table.hpp"
+
+#include <algorithm> // std::max, std::ranges::count_if
+#include <array>     // std::array
+#include <stdexcept> // std::runtime_error
+
+#include <glad/glad.h>
+
+namespace derp {
+
+auto bindless_table::supported() noexcept -> bool {
+  return GLAD_GL_ARB_bindless_texture != 0;
+}
+
+bindless_table::bindless_table(const uint32_t evict_after)
+    : evict_after(evict_after) {
+  if (!supported()) {
+    throw std::runtime_error(
+        "[ERROR] GL_ARB_bindless_texture is not supported, use texture "
+        "arrays instead");
+  }
+}
+
+bindless_table::~bindless_table() {
+  for (auto &e : entries) {
+    if (e.resident)
+      glMakeTextureHandleNonResidentARB(e.handle);
+  }
+  if (ssbo)
+    glDeleteBuffers(1, &ssbo);
+}
+
+auto bindless_table::placeholder_handle(const texture::texture_type type)
+    -> uint64_t {
+  // resident for the lifetime of the context, like the placeholders
+  static std::array<uint64_t, texture::TEXTURE_TYPES> handles{};
+
+  auto &handle = handles[static_cast<std::size_t>(type)];
+  if (!handle) {
+    handle = glGetTextureSamplerHandleARB(texture::placeholder(type),
+                                          sampler_cache::shared().get({}));
+    glMakeTextureHandleResidentARB(handle);
+  }
+  return handle;
+}
+
+auto bindless_table::add(std::shared_ptr<texture> tex) -> uint32_t {
+  handles.push_back(placeholder_handle(tex->_type));
+  entries.push_back({.tex = std::move(tex)});
+  dirty = true;
+  return static_cast<uint32_t>(entries.size() - 1);
+}
+
+auto bindless_table::mark_visible(const uint32_t index) -> void {
+  entries[index].last_seen = frame;
+}
+
+auto bindless_table::update() -> void {
+  for (std::size_t i = 0; i < entries.size(); ++i) {
+    auto &e = entries[i];
+    // 0 until streamed in, and a new one whenever the streamer swaps the
+    // storage; the old handle went with the old storage
+    if (const auto handle = e.tex->get_handle(); handle != e.handle) {
+      e.handle = handle;
+      e.resident = false;
+    }
+    if (!e.handle)
+      continue;
+
+    if (e.last_seen == frame && !e.resident) {
+      glMakeTextureHandleResidentARB(e.handle);
+      e.resident = true;
+    } else if (e.resident && frame - e.last_seen > evict_after) {
+      glMakeTextureHandleNonResidentARB(e.handle);
+      e.resident = false;
+    }
+
+    const auto value =
+        e.resident ? e.handle : placeholder_handle(e.tex->_type);
+    if (handles[i] != value) {
+      handles[i] = value;
+      dirty = true;
+    }
+  }
+  ++frame;
+
+  if (!dirty)
+    return;
+  dirty = false;
+
+  const auto size = handles.size() * sizeof(uint64_t);
+  if (size > capacity) {
+    // immutable storage, grow by recreating
+    if (ssbo)
+      glDeleteBuffers(1, &ssbo);
+    capacity = std::max<std::size_t>(size * 2, 64 * sizeof(uint64_t));
+    glCreateBuffers(1, &ssbo);
+    glNamedBufferStorage(ssbo, static_cast<GLsizeiptr>(capacity), nullptr,
+                         GL_DYNAMIC_STORAGE_BIT);
+  }
+  glNamedBufferSubData(ssbo, 0, static_cast<GLsizeiptr>(size),
+                       handles.data());
+}
+
+auto bindless_table::bind(const uint32_t binding) const -> void {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo);
+}
+
+auto bindless_table::resident_count() const noexcept -> std::size_t {
+  return static_cast<std::size_t>(
+      std::ranges::count_if(entries, [](const auto &e) { return e.resident; }));
+}
+
+} // namespace derp
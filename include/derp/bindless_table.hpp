@@ -0,0 +1,86 @@
+//===-- Implementation header for bindless table class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "texture.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // uint32_t, uint64_t
+#include <memory>  // std::shared_ptr
+#include <vector>  // std::vector
+
+namespace derp {
+
+// Material textures as ARB_bindless_texture handles in a shader storage
+// buffer, so any number of materials can be drawn without a single texture
+// bind. Shaders index the table and turn the handle into a sampler, as
+// material.frag's BINDLESS variant does through material_table:
+//
+//   #extension GL_ARB_bindless_texture : require
+//   layout(std430, binding = 2) readonly buffer bindless_handles {
+//     uvec2 handles[];
+//   };
+//   texture(sampler2D(handles[index]), uv)
+//
+// Only textures in use are resident. mark_visible() the materials about to
+// be drawn, then update() before the draws: visible textures are made
+// resident, textures unseen for `evict_after` frames lose their residency.
+// Entries that are not resident or still streaming point at the texture's
+// placeholder, so the shader never sees an invalid handle.
+//
+// Without the extension (llvmpipe, for one) supported() is false and the
+// constructor throws; material_table only makes one when supported() and
+// otherwise goes through texture_packer's arrays instead.
+class bindless_table {
+private:
+  struct entry {
+    std::shared_ptr<texture> tex;
+    uint64_t handle = 0;
+    bool resident = false;
+    uint64_t last_seen = 0;
+  };
+
+  std::vector<entry> entries;
+  std::vector<uint64_t> handles; // mirror of the buffer's contents
+  uint32_t ssbo = 0;
+  std::size_t capacity = 0;
+  bool dirty = false;
+
+  uint64_t frame = 1;
+  uint32_t evict_after;
+
+  static auto placeholder_handle(texture::texture_type type) -> uint64_t;
+
+public:
+  [[nodiscard]]
+  static auto supported() noexcept -> bool;
+
+  explicit bindless_table(uint32_t evict_after = 120);
+  ~bindless_table();
+
+  bindless_table(const bindless_table &) = delete;
+  bindless_table &operator=(const bindless_table &) = delete;
+
+  // returns the material index shaders use to look the texture up
+  [[nodiscard]]
+  auto add(std::shared_ptr<texture> tex) -> uint32_t;
+
+  auto mark_visible(uint32_t index) -> void;
+
+  // updates residency and uploads changed handles
+  auto update() -> void;
+
+  auto bind(uint32_t binding) const -> void;
+
+  [[nodiscard]]
+  auto resident_count() const noexcept -> std::size_t;
+}; // class bindless_table
+
+} // namespace derp
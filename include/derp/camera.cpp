@@ -24,6 +24,8 @@ auto camera::get_view_matrix() const -> glm::mat4 {
 
 auto camera::get_fov() const noexcept -> float { return fov; }
 
+auto camera::get_position() const noexcept -> glm::vec3 { return position; }
+
 auto camera::keyboard_move(const direction dir, const float delta_time) noexcept
     -> void {
   const float velocity = speed * delta_time;
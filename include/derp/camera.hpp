@@ -49,6 +49,9 @@ public:
   [[nodiscard]]
   auto get_fov() const noexcept -> float;
 
+  [[nodiscard]]
+  auto get_position() const noexcept -> glm::vec3;
+
   auto keyboard_move(direction dir, float delta_time = 1.0f / 60.0f) noexcept
       -> void;
 
@@ -0,0 +1,96 @@
+//===-- Implementation of channel packing ---------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "channel_pack.hpp"
+
+#include <algorithm> // std::max, std::ranges::all_of, std::ranges::find
+#include <format>    // std::format
+#include <vector>    // std::vector
+
+namespace derp {
+
+auto channel_pack::empty() const noexcept -> bool {
+  return std::ranges::all_of(channels,
+                             [](const auto &c) { return c.path.empty(); });
+}
+
+auto pack_channels(const channel_pack &pack)
+    -> std::expected<image, std::string> {
+  if (pack.count < 1 || pack.count > 4)
+    return std::unexpected(std::format("can't pack {} channels", pack.count));
+
+  // a normal map gives two channels, decode it once
+  std::vector<std::string> paths;
+  std::vector<image> sources;
+  std::array<int, 4> source_of{-1, -1, -1, -1};
+  int width = 1;
+  int height = 1;
+
+  for (int c = 0; c < pack.count; ++c) {
+    const auto &src = pack.channels[c];
+    if (src.path.empty())
+      continue;
+
+    auto it = std::ranges::find(paths, src.path);
+    if (it == paths.end()) {
+      auto img = load_image(src.path);
+      if (!img)
+        return std::unexpected(std::format("{}: {}", src.path, img.error()));
+      if (img->type != pixel_type::UNORM8)
+        return std::unexpected(std::format("{}: not 8 bit", src.path));
+
+      const auto &base = img->levels.front();
+      width = std::max(width, base.width);
+      height = std::max(height, base.height);
+      paths.push_back(src.path);
+      sources.push_back(std::move(*img));
+      it = paths.end() - 1;
+    }
+
+    const auto index = static_cast<int>(it - paths.begin());
+    if (src.channel < 0 || src.channel >= sources[index].channels) {
+      return std::unexpected(std::format("{}: has no channel {}", src.path,
+                                         src.channel));
+    }
+    source_of[c] = index;
+  }
+
+  image out;
+  out.channels = pack.count;
+  out.levels.push_back(make_level(width, height, pack.count));
+  auto *dst = out.levels.front().pixels.get();
+  const auto n = static_cast<std::size_t>(pack.count);
+
+  for (int c = 0; c < pack.count; ++c) {
+    const auto &src = pack.channels[c];
+    if (source_of[c] < 0) {
+      for (std::size_t i = c; i < out.levels.front().size; i += n)
+        dst[i] = src.fill;
+      continue;
+    }
+
+    const auto &img = sources[source_of[c]];
+    const auto &base = img.levels.front();
+    const auto *pixels = base.pixels.get();
+    const auto stride = static_cast<std::size_t>(img.channels);
+
+    for (int y = 0; y < height; ++y) {
+      const auto sy = static_cast<std::size_t>(y * base.height / height);
+      for (int x = 0; x < width; ++x) {
+        const auto sx = static_cast<std::size_t>(x * base.width / width);
+        const auto texel = sy * static_cast<std::size_t>(base.width) + sx;
+        dst[(static_cast<std::size_t>(y) * width + x) * n + c] =
+            pixels[texel * stride + src.channel];
+      }
+    }
+  }
+  return out;
+}
+
+} // namespace derp
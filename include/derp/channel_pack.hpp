@@ -0,0 +1,52 @@
+//===-- Implementation header for channel packing -------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+
+#include <array>    // std::array
+#include <cstdint>  // uint8_t
+#include <expected> // std::expected
+#include <string>   // std::string
+
+namespace derp {
+
+// where one channel of a packed texture comes from
+struct channel_source {
+  std::string path; // empty fills the channel with `fill`
+  int channel = 0;  // channel of the source image to take
+  uint8_t fill = 255;
+
+  auto operator==(const channel_source &) const -> bool = default;
+};
+
+// Up to four channels of different images in one texture, e.g. a height map
+// in the alpha of a normal map or occlusion, roughness and metalness in the
+// channels of one ORM texture. The shader then binds and fetches one texture
+// instead of one per map.
+struct channel_pack {
+  std::array<channel_source, 4> channels;
+  int count = 4; // channels of the packed image
+
+  // true if no channel has a source
+  [[nodiscard]]
+  auto empty() const noexcept -> bool;
+
+  auto operator==(const channel_pack &) const -> bool = default;
+};
+
+// decodes every source once and interleaves the picked channels into a single
+// level UNORM8 image. sources may differ in size, they are point sampled to
+// the largest one. fails if a source is not 8 bit or lacks the channel.
+[[nodiscard]]
+auto pack_channels(const channel_pack &pack)
+    -> std::expected<image, std::string>;
+
+} // namespace derp
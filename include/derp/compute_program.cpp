@@ -0,0 +1,118 @@
+//===-- Implementation of compute program class ---------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "compute_program.hpp"
+
+#include <algorithm> // std::ranges::find_if
+#include <array>     // std::array
+#include <utility>   // std::move
+
+namespace derp {
+
+namespace {
+
+auto image_access(const access mode) -> uint32_t {
+  switch (mode) {
+  case access::READ:
+    return GL_READ_ONLY;
+  case access::WRITE:
+    return GL_WRITE_ONLY;
+  default:
+    return GL_READ_WRITE;
+  }
+}
+
+} // namespace
+
+compute_program::compute_program(shader program)
+    : program(std::move(program)) {
+  std::array<int, 3> size{};
+  glGetProgramiv(this->program.get_id(), GL_COMPUTE_WORK_GROUP_SIZE,
+                 size.data());
+  local_size = glm::uvec3(size[0], size[1], size[2]);
+}
+
+auto compute_program::set(const binding &b) -> void {
+  const auto it = std::ranges::find_if(bindings, [&](const binding &other) {
+    return other.kind == b.kind && other.index == b.index;
+  });
+  if (it != bindings.end())
+    *it = b;
+  else
+    bindings.push_back(b);
+}
+
+auto compute_program::bind_image(const uint32_t unit, const uint32_t texture,
+                                 const uint32_t format, const access mode,
+                                 const uint32_t level) -> void {
+  set({.kind = gpu_resource::TEXTURE,
+       .id = texture,
+       .index = unit,
+       .format = format,
+       .level = level,
+       .mode = mode});
+}
+
+auto compute_program::groups_for(const glm::uvec3 items) const noexcept
+    -> glm::uvec3 {
+  return (items + local_size - 1u) / local_size;
+}
+
+auto compute_program::begin_pass() -> void {
+  program.use();
+  uniform_shadow::flush_all();
+
+  auto &barriers = memory_barriers::shared();
+  for (const auto &b : bindings) {
+    // writes after writes need the barrier as much as reads do
+    if (b.kind == gpu_resource::BUFFER) {
+      glBindBufferBase(GL_SHADER_STORAGE_BUFFER, b.index, b.id);
+      barriers.need(b.kind, b.id, GL_SHADER_STORAGE_BARRIER_BIT);
+    } else {
+      glBindImageTexture(b.index, b.id, static_cast<int>(b.level), GL_TRUE, 0,
+                         image_access(b.mode), b.format);
+      barriers.need(b.kind, b.id, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    }
+  }
+}
+
+auto compute_program::end_pass() -> void {
+  auto &barriers = memory_barriers::shared();
+  for (const auto &b : bindings)
+    if (b.mode != access::READ)
+      barriers.wrote(b.kind, b.id);
+}
+
+auto compute_program::dispatch(const glm::uvec3 groups) -> void {
+  begin_pass();
+  memory_barriers::shared().flush();
+  glDispatchCompute(groups.x, groups.y, groups.z);
+  end_pass();
+}
+
+auto compute_program::dispatch_indirect(const gpu_buffer &buffer,
+                                        const std::size_t offset) -> void {
+  begin_pass();
+  auto &barriers = memory_barriers::shared();
+  barriers.need(gpu_resource::BUFFER, buffer.get_id(), GL_COMMAND_BARRIER_BIT);
+  barriers.flush();
+  glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer.get_id());
+  glDispatchComputeIndirect(static_cast<GLintptr>(offset));
+  end_pass();
+}
+
+auto compute_program::get_local_size() const noexcept -> glm::uvec3 {
+  return local_size;
+}
+
+auto compute_program::get_shader() const noexcept -> const shader & {
+  return program;
+}
+
+} // namespace derp
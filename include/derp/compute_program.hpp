@@ -0,0 +1,96 @@
+//===-- Implementation header for compute program class -------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "memory_barriers.hpp"
+#include "shader.hpp"
+#include "typed_buffer.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // uint32_t
+#include <vector>  // std::vector
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+namespace derp {
+
+enum class access { READ, WRITE, READ_WRITE };
+
+// A linked compute shader and the resources one dispatch of it touches.
+//
+// Bindings are declared once, storage buffers at the binding of their block,
+// images at a unit, each with how the shader accesses it. Every dispatch
+// binds them, issues the barriers earlier passes left for what it reads (and
+// overwrites) through memory_barriers, and records what it writes, so the
+// pass consuming the results gets exactly the barrier it needs.
+class compute_program {
+private:
+  struct binding {
+    gpu_resource kind;
+    uint32_t id;
+    uint32_t index;  // storage block binding or image unit
+    uint32_t format; // images only
+    uint32_t level;  // images only
+    access mode;
+  };
+
+  shader program;
+  glm::uvec3 local_size;
+  std::vector<binding> bindings;
+
+  auto set(const binding &b) -> void;
+  // uses the program, binds everything and need()s what earlier passes wrote
+  auto begin_pass() -> void;
+  // records what the pass wrote
+  auto end_pass() -> void;
+
+public:
+  // takes over a program with a compute stage, from
+  // shader_compiler::submit_compute
+  explicit compute_program(shader program);
+
+  // storage block `block_traits<T>::binding` reads `buffer`
+  template <typename T>
+  auto bind(const storage_buffer<T> &buffer, const access mode = access::READ)
+      -> void {
+    set({.kind = gpu_resource::BUFFER,
+         .id = buffer.get_id(),
+         .index = block_traits<T>::binding,
+         .format = 0,
+         .level = 0,
+         .mode = mode});
+  }
+
+  // image unit `unit` is level `level` of `texture`, as `format`
+  // (GL_RGBA8, ...)
+  auto bind_image(uint32_t unit, uint32_t texture, uint32_t format,
+                  access mode, uint32_t level = 0) -> void;
+
+  // groups of local_size, enough to cover `items` invocations
+  [[nodiscard]]
+  auto groups_for(glm::uvec3 items) const noexcept -> glm::uvec3;
+
+  auto dispatch(glm::uvec3 groups) -> void;
+
+  // group counts from a DispatchIndirectCommand at `offset` in `buffer`,
+  // possibly written by an earlier pass
+  auto dispatch_indirect(const gpu_buffer &buffer, std::size_t offset = 0)
+      -> void;
+
+  [[nodiscard]]
+  auto get_local_size() const noexcept -> glm::uvec3;
+
+  [[nodiscard]]
+  auto get_shader() const noexcept -> const shader &;
+}; // class compute_program
+
+} // namespace derp
@@ -0,0 +1,182 @@
+//===-- Implementation of GL state tracker class --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gl_state.hpp"
+
+#include <algorithm> // std::ranges::equal, std::ranges::copy, std::min
+#include <format>    // std::format
+#include <stdexcept> // std::runtime_error
+
+#include <glad/glad.h>
+
+namespace derp {
+
+gl_state::gl_state() { invalidate(); }
+
+auto gl_state::shared() -> gl_state & {
+  static gl_state state;
+  return state;
+}
+
+auto gl_state::use_program(const uint32_t id) -> void {
+  if (program == id)
+    return;
+  glUseProgram(id);
+  program = id;
+}
+
+auto gl_state::bind_pipeline(const uint32_t id) -> void {
+  use_program(0);
+  if (pipeline == id)
+    return;
+  glBindProgramPipeline(id);
+  pipeline = id;
+}
+
+auto gl_state::bind_vertex_array(const uint32_t id) -> void {
+  if (vertex_array == id)
+    return;
+  glBindVertexArray(id);
+  vertex_array = id;
+}
+
+auto gl_state::bind_framebuffer(const uint32_t id) -> void {
+  if (framebuffer == id)
+    return;
+  glBindFramebuffer(GL_FRAMEBUFFER, id);
+  framebuffer = id;
+}
+
+auto gl_state::set_viewport(const int x, const int y, const int width,
+                            const int height) -> void {
+  const std::array wanted{x, y, width, height};
+  if (viewport == wanted)
+    return;
+  glViewport(x, y, width, height);
+  viewport = wanted;
+}
+
+auto gl_state::bind_texture(const uint32_t unit, const uint32_t id) -> void {
+  if (unit < MAX_UNITS) {
+    if (textures[unit] == id)
+      return;
+    textures[unit] = id;
+  }
+  glBindTextureUnit(unit, id);
+}
+
+auto gl_state::bind_sampler(const uint32_t unit, const uint32_t id) -> void {
+  if (unit < MAX_UNITS) {
+    if (samplers[unit] == id)
+      return;
+    samplers[unit] = id;
+  }
+  glBindSampler(unit, id);
+}
+
+namespace {
+
+// true if the mirrored part of [first, first + ids.size()) already matches,
+// updates it otherwise
+auto update(std::span<uint32_t> mirror, const uint32_t first,
+            const std::span<const uint32_t> ids) -> bool {
+  const auto end = std::min<std::size_t>(first + ids.size(), mirror.size());
+  const auto mirrored = first < end ? end - first : 0;
+  const auto current = mirror.subspan(std::min<std::size_t>(first, end),
+                                      mirrored);
+  const auto wanted = ids.first(mirrored);
+  if (mirrored == ids.size() && std::ranges::equal(current, wanted))
+    return true;
+  std::ranges::copy(wanted, current.begin());
+  return false;
+}
+
+} // namespace
+
+auto gl_state::bind_textures(const uint32_t first,
+                             const std::span<const uint32_t> ids) -> void {
+  if (ids.empty() || update(textures, first, ids))
+    return;
+  glBindTextures(first, static_cast<GLsizei>(ids.size()), ids.data());
+}
+
+auto gl_state::bind_samplers(const uint32_t first,
+                             const std::span<const uint32_t> ids) -> void {
+  if (ids.empty() || update(samplers, first, ids))
+    return;
+  glBindSamplers(first, static_cast<GLsizei>(ids.size()), ids.data());
+}
+
+auto gl_state::forget_program(const uint32_t id) -> void {
+  // a deleted program stays in use until another one is, unbind it
+  if (program == id)
+    use_program(0);
+}
+
+auto gl_state::forget_pipeline(const uint32_t id) -> void {
+  if (pipeline == id)
+    pipeline = 0;
+}
+
+auto gl_state::forget_vertex_array(const uint32_t id) -> void {
+  if (vertex_array == id)
+    vertex_array = 0;
+}
+
+auto gl_state::forget_framebuffer(const uint32_t id) -> void {
+  // deleting the bound framebuffer falls back to the default one
+  if (framebuffer == id)
+    framebuffer = 0;
+}
+
+auto gl_state::forget_texture(const uint32_t id) -> void {
+  for (auto &bound : textures)
+    if (bound == id)
+      bound = 0;
+}
+
+auto gl_state::invalidate() -> void {
+  program = UNKNOWN;
+  pipeline = UNKNOWN;
+  vertex_array = UNKNOWN;
+  framebuffer = UNKNOWN;
+  viewport = {0, 0, static_cast<int>(UNKNOWN), 0};
+  textures.fill(UNKNOWN);
+  samplers.fill(UNKNOWN);
+}
+
+auto gl_state::get_program() const noexcept -> uint32_t { return program; }
+
+auto gl_state::get_viewport() -> std::array<int, 4> {
+  if (viewport[2] == static_cast<int>(UNKNOWN))
+    glGetIntegerv(GL_VIEWPORT, viewport.data());
+  return viewport;
+}
+
+auto gl_state::verify() const -> void {
+#ifdef DERP_GL_STATE_CHECKS
+  const auto check = [](const char *what, const GLenum name,
+                        const uint32_t mirrored) {
+    int actual = 0;
+    glGetIntegerv(name, &actual);
+    if (mirrored != UNKNOWN && static_cast<uint32_t>(actual) != mirrored) {
+      throw std::runtime_error(std::format(
+          "[ERROR] {} {} is bound, the state tracker thinks {} is. something "
+          "bound around it",
+          what, actual, mirrored));
+    }
+  };
+  check("program", GL_CURRENT_PROGRAM, program);
+  check("program pipeline", GL_PROGRAM_PIPELINE_BINDING, pipeline);
+  check("vertex array", GL_VERTEX_ARRAY_BINDING, vertex_array);
+  check("framebuffer", GL_DRAW_FRAMEBUFFER_BINDING, framebuffer);
+#endif
+}
+
+} // namespace derp
@@ -0,0 +1,88 @@
+//===-- Implementation header for GL state tracker class ------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>   // std::array
+#include <cstdint> // uint32_t
+#include <span>    // std::span
+
+namespace derp {
+
+// CPU side mirror of the context's bindings: program, program pipeline,
+// vertex array, framebuffer, viewport, and the texture and sampler of each
+// unit. Binds that wouldn't change anything are skipped, and nothing ever has
+// to ask GL what is bound.
+//
+// Every bind of these kinds has to go through here, and every delete of a
+// bound object has to be reported with forget_*(): GL unbinds deleted objects
+// and hands their names out again. Code that binds around the tracker calls
+// invalidate() afterwards. Builds with DERP_GL_STATE_CHECKS check the mirror
+// against GL in verify(), each check is a round trip to the driver.
+class gl_state {
+public:
+  static constexpr uint32_t MAX_UNITS = 32; // units past this aren't mirrored
+
+private:
+  static constexpr uint32_t UNKNOWN = ~0u; // no GL name, forces the next bind
+
+  uint32_t program = UNKNOWN;
+  uint32_t pipeline = UNKNOWN;
+  uint32_t vertex_array = UNKNOWN;
+  uint32_t framebuffer = UNKNOWN; // draw and read, they're bound together
+  std::array<int, 4> viewport;    // x, y, width, height, UNKNOWN width if lost
+  std::array<uint32_t, MAX_UNITS> textures;
+  std::array<uint32_t, MAX_UNITS> samplers;
+
+  gl_state();
+
+public:
+  gl_state(const gl_state &) = delete;
+  gl_state &operator=(const gl_state &) = delete;
+
+  // the state of the one context, render thread only
+  [[nodiscard]]
+  static auto shared() -> gl_state &;
+
+  auto use_program(uint32_t id) -> void;
+  // a pipeline only runs with no program in use, this unbinds the program
+  auto bind_pipeline(uint32_t id) -> void;
+  auto bind_vertex_array(uint32_t id) -> void;
+  auto bind_framebuffer(uint32_t id) -> void;
+  auto set_viewport(int x, int y, int width, int height) -> void;
+  auto bind_texture(uint32_t unit, uint32_t id) -> void;
+  auto bind_sampler(uint32_t unit, uint32_t id) -> void;
+
+  // one glBindTextures/glBindSamplers, none if every unit already matches
+  auto bind_textures(uint32_t first, std::span<const uint32_t> ids) -> void;
+  auto bind_samplers(uint32_t first, std::span<const uint32_t> ids) -> void;
+
+  // call before deleting the object
+  auto forget_program(uint32_t id) -> void;
+  auto forget_pipeline(uint32_t id) -> void;
+  auto forget_vertex_array(uint32_t id) -> void;
+  auto forget_framebuffer(uint32_t id) -> void;
+  auto forget_texture(uint32_t id) -> void;
+
+  // after GL calls that went around the tracker
+  auto invalidate() -> void;
+
+  [[nodiscard]]
+  auto get_program() const noexcept -> uint32_t;
+
+  // queries GL only when invalidate() lost it
+  [[nodiscard]]
+  auto get_viewport() -> std::array<int, 4>;
+
+  // throws if the mirror and GL disagree, does nothing without
+  // DERP_GL_STATE_CHECKS
+  auto verify() const -> void;
+}; // class gl_state
+
+} // namespace derp
@@ -0,0 +1,177 @@
+//===-- Implementation of GLSL preprocessor class -------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "glsl_preprocessor.hpp"
+
+#include <algorithm> // std::ranges::count, std::ranges::find
+#include <format>    // std::format
+#include <fstream>   // std::ifstream
+#include <optional>  // std::optional
+#include <utility>   // std::move
+
+namespace derp {
+
+namespace {
+
+auto read_file(const std::filesystem::path &path)
+    -> std::optional<std::string> {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file)
+    return std::nullopt;
+  const auto size = file.tellg();
+  std::string content;
+  content.resize(size);
+  file.seekg(0);
+  if (!file.read(content.data(), size))
+    return std::nullopt;
+  return content;
+}
+
+// the name in `#include "name"` or `#include <name>`
+auto include_target(std::string_view line) -> std::optional<std::string_view> {
+  const auto trim = [](std::string_view &s) {
+    s.remove_prefix(std::min(s.find_first_not_of(" \t"), s.size()));
+  };
+  trim(line);
+  if (!line.starts_with("#include"))
+    return std::nullopt;
+  line.remove_prefix(8);
+  trim(line);
+  if (line.empty() || (line[0] != '"' && line[0] != '<'))
+    return std::nullopt;
+  const auto close = line.find(line[0] == '"' ? '"' : '>', 1);
+  if (close == std::string_view::npos)
+    return std::nullopt;
+  return line.substr(1, close - 1);
+}
+
+// `lines` after the #version line, and a #line so logs still point at the
+// right line of the file
+auto after_version(const std::string_view source, const std::string_view lines)
+    -> std::string {
+  const auto version = source.find("#version");
+  const auto eol = source.find('\n', version);
+  if (version == std::string_view::npos || eol == std::string_view::npos)
+    return std::format("{}{}", lines, source);
+
+  const auto head = source.substr(0, eol + 1);
+  return std::format("{}{}#line {}\n{}", head, lines,
+                     std::ranges::count(head, '\n') + 1,
+                     source.substr(eol + 1));
+}
+
+} // namespace
+
+struct glsl_preprocessor::state {
+  preprocessed out;
+  std::vector<std::string> seen; // generated names and absolute paths
+};
+
+glsl_preprocessor::glsl_preprocessor() : include_dirs{DEFAULT_INCLUDE_DIR} {}
+
+auto glsl_preprocessor::add_include_dir(std::filesystem::path dir) -> void {
+  include_dirs.push_back(std::move(dir));
+}
+
+auto glsl_preprocessor::add_generated(std::string name, std::string source)
+    -> void {
+  generated.insert_or_assign(std::move(name), std::move(source));
+}
+
+auto glsl_preprocessor::expand(const std::string_view text,
+                               const std::size_t number, state &s) const
+    -> std::expected<void, std::string> {
+  const auto dir = s.out.files[number].parent_path();
+  std::size_t line_no = 0;
+  for (std::size_t begin = 0; begin < text.size();) {
+    const auto end = std::min(text.find('\n', begin), text.size());
+    const auto line = text.substr(begin, end - begin);
+    begin = end + 1;
+    ++line_no;
+
+    const auto name = include_target(line);
+    if (!name) {
+      s.out.source += line;
+      s.out.source += '\n';
+      continue;
+    }
+
+    std::string id;
+    std::filesystem::path path;
+    std::optional<std::string> content;
+    if (const auto it = generated.find(std::string(*name));
+        it != generated.end()) {
+      id = path = *name;
+      content = it->second;
+    } else {
+      auto candidates = include_dirs;
+      if (!dir.empty())
+        candidates.insert(candidates.begin(), dir);
+      for (const auto &candidate : candidates) {
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(candidate / *name, ec)) {
+          path = candidate / *name;
+          id = std::filesystem::absolute(path).lexically_normal().string();
+          content = read_file(path);
+          break;
+        }
+      }
+    }
+    if (!content) {
+      return std::unexpected(
+          std::format("[ERROR] {}:{}: can't include \"{}\"",
+                      s.out.files[number].string(), line_no, *name));
+    }
+
+    if (std::ranges::find(s.seen, id) != s.seen.end()) {
+      s.out.source += '\n'; // pasted already, keep the numbering
+      continue;
+    }
+    s.seen.push_back(std::move(id));
+
+    const auto child = s.out.files.size();
+    s.out.files.push_back(std::move(path));
+    s.out.source += std::format("#line 1 {}\n", child);
+    if (auto expanded = expand(*content, child, s); !expanded)
+      return expanded;
+    s.out.source += std::format("#line {} {}\n", line_no + 1, number);
+  }
+  return {};
+}
+
+auto glsl_preprocessor::process(const std::filesystem::path &file,
+                                const std::span<const std::string> defines)
+    const -> std::expected<preprocessed, std::string> {
+  const auto content = read_file(file);
+  if (!content) {
+    return std::unexpected(
+        std::format("[ERROR] Couldn't open file: {}.", file.string()));
+  }
+
+  state s;
+  s.out.files.push_back(file);
+  s.seen.push_back(std::filesystem::absolute(file).lexically_normal().string());
+  if (auto expanded = expand(*content, 0, s); !expanded)
+    return std::unexpected(std::move(expanded.error()));
+
+  if (!defines.empty()) {
+    std::string lines;
+    for (const auto &define : defines) {
+      const auto space = define.find(' ');
+      lines += space == std::string::npos
+                   ? std::format("#define {}\n", define)
+                   : std::format("#define {} {}\n", define.substr(0, space),
+                                 define.substr(space + 1));
+    }
+    s.out.source = after_version(s.out.source, lines);
+  }
+  return std::move(s.out);
+}
+
+} // namespace derp
@@ -0,0 +1,69 @@
+//===-- Implementation header for GLSL preprocessor class -----------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>       // std::size_t
+#include <expected>      // std::expected
+#include <filesystem>    // std::filesystem::path
+#include <span>          // std::span
+#include <string>        // std::string
+#include <string_view>   // std::string_view
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+namespace derp {
+
+// a shader file with its includes pasted in
+struct preprocessed {
+  std::string source;
+  // the file, then every file it included. #line directives number them in
+  // this order, so "2(14)" in a driver log is line 14 of files[2]
+  std::vector<std::filesystem::path> files;
+};
+
+// The part of a C preprocessor GLSL lacks.
+//
+// `#include "name"` (or <name>) is replaced by the file, looked up among the
+// generated sources first, then next to the including file, then in the
+// include directories. Every file is pasted once per shader, later includes
+// of it are dropped, so shared files need no guards. #define lines for the
+// requested defines go right after #version.
+class glsl_preprocessor {
+public:
+  static constexpr std::string_view DEFAULT_INCLUDE_DIR =
+      RESOURCES_PATH "/shaders/include";
+
+private:
+  std::vector<std::filesystem::path> include_dirs;
+  std::unordered_map<std::string, std::string> generated; // name, source
+
+  struct state;
+
+  [[nodiscard]]
+  auto expand(std::string_view text, std::size_t number, state &s) const
+      -> std::expected<void, std::string>;
+
+public:
+  glsl_preprocessor();
+
+  auto add_include_dir(std::filesystem::path dir) -> void;
+
+  // makes `source` includable as `name`, for code written by the program
+  // such as typed_buffer block declarations
+  auto add_generated(std::string name, std::string source) -> void;
+
+  // `defines` are "NAME" or "NAME VALUE"
+  [[nodiscard]]
+  auto process(const std::filesystem::path &file,
+               std::span<const std::string> defines = {}) const
+      -> std::expected<preprocessed, std::string>;
+}; // class glsl_preprocessor
+
+} // namespace derp
@@ -0,0 +1,32 @@
+//===-- Implementation header for hashing helpers -------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>     // uint64_t
+#include <string_view> // std::string_view
+
+namespace derp {
+
+// 64 bit FNV-1a. Stable across runs, builds and standard libraries (unlike
+// std::hash), so it is safe to use for on-disk cache keys.
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+[[nodiscard]]
+constexpr auto fnv1a(const std::string_view bytes,
+                     uint64_t hash = FNV_OFFSET_BASIS) noexcept -> uint64_t {
+  for (const char c : bytes) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= FNV_PRIME;
+  }
+  return hash;
+}
+
+} // namespace derp
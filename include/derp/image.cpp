@@ -0,0 +1,269 @@
+//===-- Implementation of image helpers -----------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "image.hpp"
+#include "mapped_file.hpp"
+
+#include <algorithm> // std::min, std::max, std::clamp
+#include <array>     // std::array
+#include <bit>       // std::bit_width
+#include <cmath>     // std::pow
+#include <cstdlib>   // std::malloc, std::free
+#include <new>       // std::bad_alloc
+#include <limits>    // std::numeric_limits
+#include <numeric>   // std::accumulate
+
+#include <stb/stb_image.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DERP_SSE2 1
+#endif
+
+namespace derp {
+
+namespace {
+
+struct srgb_tables {
+  std::array<float, 256> to_linear{};
+  std::array<unsigned char, 4096> from_linear{};
+
+  srgb_tables() {
+    for (size_t i = 0; i < to_linear.size(); ++i) {
+      const float c = static_cast<float>(i) / 255.0f;
+      to_linear[i] = c <= 0.04045f ? c / 12.92f
+                                   : std::pow((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (size_t i = 0; i < from_linear.size(); ++i) {
+      const float l = static_cast<float>(i) / 4095.0f;
+      const float s = l <= 0.0031308f
+                          ? l * 12.92f
+                          : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+      from_linear[i] = static_cast<unsigned char>(s * 255.0f + 0.5f);
+    }
+  }
+};
+
+auto tables() -> const srgb_tables & {
+  static const srgb_tables t;
+  return t;
+}
+
+auto is_alpha(const int channel, const int channels) -> bool {
+  return (channels == 4 && channel == 3) || (channels == 2 && channel == 1);
+}
+
+// every pixel is widened to 4 floats so the filter is one SSE op per pixel
+auto decode(const image::level &src, const int channels, const bool srgb,
+            const pixel_type type, std::vector<float> &dst) -> void {
+  const auto &lut = tables().to_linear;
+  const auto pixel_count = static_cast<size_t>(src.width) * src.height;
+  dst.assign(pixel_count * 4, 0.0f);
+
+  if (type == pixel_type::FLOAT) {
+    const auto *texels = reinterpret_cast<const float *>(src.pixels.get());
+    for (size_t i = 0; i < pixel_count; ++i) {
+      for (int c = 0; c < channels; ++c)
+        dst[i * 4 + c] = texels[i * channels + c];
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < pixel_count; ++i) {
+    for (int c = 0; c < channels; ++c) {
+      const unsigned char v = src.pixels.get()[i * channels + c];
+      dst[i * 4 + c] = (srgb && !is_alpha(c, channels))
+                           ? lut[v]
+                           : static_cast<float>(v) / 255.0f;
+    }
+  }
+}
+
+auto encode(const std::vector<float> &src, const int channels, const bool srgb,
+            const pixel_type type, image::level &dst) -> void {
+  const auto &lut = tables().from_linear;
+  const auto pixel_count = static_cast<size_t>(dst.width) * dst.height;
+
+  if (type == pixel_type::FLOAT) {
+    auto *texels = reinterpret_cast<float *>(dst.pixels.get());
+    for (size_t i = 0; i < pixel_count; ++i) {
+      for (int c = 0; c < channels; ++c)
+        texels[i * channels + c] = src[i * 4 + c];
+    }
+    return;
+  }
+
+  for (size_t i = 0; i < pixel_count; ++i) {
+    for (int c = 0; c < channels; ++c) {
+      const float v = std::clamp(src[i * 4 + c], 0.0f, 1.0f);
+      dst.pixels.get()[i * channels + c] =
+          (srgb && !is_alpha(c, channels))
+              ? lut[static_cast<size_t>(v * 4095.0f + 0.5f)]
+              : static_cast<unsigned char>(v * 255.0f + 0.5f);
+    }
+  }
+}
+
+// 2x2 box filter, odd edges repeat the last texel
+auto downsample(const std::vector<float> &src, const int w, const int h,
+                std::vector<float> &dst, const int nw, const int nh) -> void {
+  dst.resize(static_cast<size_t>(nw) * nh * 4);
+
+  for (int y = 0; y < nh; ++y) {
+    const size_t row0 = static_cast<size_t>(std::min(2 * y, h - 1)) * w;
+    const size_t row1 = static_cast<size_t>(std::min(2 * y + 1, h - 1)) * w;
+
+    for (int x = 0; x < nw; ++x) {
+      const size_t x0 = std::min(2 * x, w - 1);
+      const size_t x1 = std::min(2 * x + 1, w - 1);
+      float *out = &dst[(static_cast<size_t>(y) * nw + x) * 4];
+
+#ifdef DERP_SSE2
+      const __m128 sum = _mm_add_ps(
+          _mm_add_ps(_mm_loadu_ps(&src[(row0 + x0) * 4]),
+                     _mm_loadu_ps(&src[(row0 + x1) * 4])),
+          _mm_add_ps(_mm_loadu_ps(&src[(row1 + x0) * 4]),
+                     _mm_loadu_ps(&src[(row1 + x1) * 4])));
+      _mm_storeu_ps(out, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+      for (int c = 0; c < 4; ++c) {
+        out[c] = 0.25f *
+                 (src[(row0 + x0) * 4 + c] + src[(row0 + x1) * 4 + c] +
+                  src[(row1 + x0) * 4 + c] + src[(row1 + x1) * 4 + c]);
+      }
+#endif
+    }
+  }
+}
+
+} // namespace
+
+auto image::size() const noexcept -> std::size_t {
+  return std::accumulate(
+      levels.begin(), levels.end(), std::size_t{0},
+      [](const std::size_t sum, const level &l) { return sum + l.size; });
+}
+
+auto image::format() const noexcept -> texel_format {
+  return {channels, block, type, srgb};
+}
+
+auto block_bytes(const block_format block) noexcept -> std::size_t {
+  switch (block) {
+  case block_format::BC1:
+  case block_format::BC4:
+    return 8;
+  case block_format::BC3:
+  case block_format::BC5:
+  case block_format::BC7:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+auto pixel_bytes(const int channels, const pixel_type type) noexcept
+    -> std::size_t {
+  const auto n = static_cast<std::size_t>(channels);
+  switch (type) {
+  case pixel_type::HALF:
+    return n * 2;
+  case pixel_type::FLOAT:
+    return n * 4;
+  case pixel_type::R11G11B10F:
+    return 4;
+  default:
+    return n;
+  }
+}
+
+auto level_size(const int width, const int height, const int channels,
+                const block_format block, const pixel_type type) noexcept
+    -> std::size_t {
+  if (block == block_format::NONE)
+    return static_cast<std::size_t>(width) * height *
+           pixel_bytes(channels, type);
+
+  const auto blocks_x = static_cast<std::size_t>(width + 3) / 4;
+  const auto blocks_y = static_cast<std::size_t>(height + 3) / 4;
+  return blocks_x * blocks_y * block_bytes(block);
+}
+
+auto load_image(const std::filesystem::path &path)
+    -> std::expected<image, std::string> {
+  const mapped_file file{path};
+  if (!file)
+    return std::unexpected("can't open file");
+  if (file.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+    return std::unexpected("file too large");
+
+  const auto *data = file.data();
+  const auto length = static_cast<int>(file.size());
+  const bool hdr = stbi_is_hdr_from_memory(data, length) != 0;
+
+  int w, h, n;
+  unsigned char *pixels =
+      hdr ? reinterpret_cast<unsigned char *>(
+                stbi_loadf_from_memory(data, length, &w, &h, &n, 0))
+          : stbi_load_from_memory(data, length, &w, &h, &n, 0);
+  if (!pixels)
+    return std::unexpected(stbi_failure_reason());
+
+  image img;
+  img.channels = n;
+  img.type = hdr ? pixel_type::FLOAT : pixel_type::UNORM8;
+  const auto size = level_size(w, h, n, block_format::NONE, img.type);
+  img.levels.push_back({w, h, size, {pixels, stbi_image_free}});
+  return img;
+}
+
+auto make_level(const int width, const int height, const int channels,
+                const block_format block, const pixel_type type)
+    -> image::level {
+  const auto size = level_size(width, height, channels, block, type);
+  auto *pixels = static_cast<unsigned char *>(std::malloc(size));
+  if (!pixels)
+    throw std::bad_alloc();
+  return {width, height, size, {pixels, std::free}};
+}
+
+auto mip_count(const int width, const int height) noexcept -> int {
+  return static_cast<int>(
+      std::bit_width(static_cast<unsigned>(std::max({width, height, 1}))));
+}
+
+auto generate_mips(image &img) -> void {
+  img.levels.erase(img.levels.begin() + 1, img.levels.end());
+
+  int w = img.levels.front().width;
+  int h = img.levels.front().height;
+  const int count = mip_count(w, h);
+  img.levels.reserve(count);
+
+  std::vector<float> current;
+  std::vector<float> next;
+  decode(img.levels.front(), img.channels, img.srgb, img.type, current);
+
+  for (int i = 1; i < count; ++i) {
+    const int nw = std::max(1, w / 2);
+    const int nh = std::max(1, h / 2);
+
+    downsample(current, w, h, next, nw, nh);
+
+    auto &level = img.levels.emplace_back(
+        make_level(nw, nh, img.channels, block_format::NONE, img.type));
+    encode(next, img.channels, img.srgb, img.type, level);
+
+    std::swap(current, next);
+    w = nw;
+    h = nh;
+  }
+}
+
+} // namespace derp
@@ -0,0 +1,100 @@
+//===-- Implementation header for image helpers ---------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint8_t
+#include <expected>   // std::expected
+#include <filesystem> // std::filesystem::path
+#include <memory>     // std::unique_ptr
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+namespace derp {
+
+// GPU block compression of an image, NONE for plain texels
+enum class block_format : uint8_t { NONE, BC1, BC3, BC4, BC5, BC7 };
+
+// what the channels of an uncompressed texel are stored as. R11G11B10F packs
+// three unsigned floats into 32 bits, the others are per channel.
+enum class pixel_type : uint8_t { UNORM8, HALF, FLOAT, R11G11B10F };
+
+// everything that decides the GL formats of an image
+struct texel_format {
+  int channels = 0;
+  block_format block = block_format::NONE;
+  pixel_type type = pixel_type::UNORM8;
+  bool srgb = false;
+
+  auto operator==(const texel_format &) const -> bool = default;
+};
+
+// CPU side pixels of a texture. either texels of `type` with tightly packed
+// rows, or 4x4 compressed blocks in row major block order.
+struct image {
+  struct level {
+    int width = 0;
+    int height = 0;
+    std::size_t size = 0;
+    // stb hands out its own allocations, the deleter travels with them
+    std::unique_ptr<unsigned char, void (*)(void *)> pixels{nullptr, nullptr};
+  };
+
+  int channels = 0; // for compressed images, the channels the format decodes
+  bool srgb = false; // colour channels are sRGB encoded, alpha never is
+  block_format block = block_format::NONE;
+  pixel_type type = pixel_type::UNORM8; // only for uncompressed images
+  std::vector<level> levels;            // base level first
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t;
+
+  [[nodiscard]]
+  auto format() const noexcept -> texel_format;
+};
+
+// bytes of one 4x4 block, 0 for NONE
+[[nodiscard]]
+auto block_bytes(block_format block) noexcept -> std::size_t;
+
+// bytes of one uncompressed texel
+[[nodiscard]]
+auto pixel_bytes(int channels, pixel_type type) noexcept -> std::size_t;
+
+[[nodiscard]]
+auto level_size(int width, int height, int channels,
+                block_format block = block_format::NONE,
+                pixel_type type = pixel_type::UNORM8) noexcept -> std::size_t;
+
+// decodes a PNG, JPEG, TGA, ... from a memory mapped file into a single
+// level, the pixels are stb's own allocation and are never copied. rows are
+// stored top row first as in the file, nothing is flipped: the vertex
+// shaders flip v instead. Radiance .hdr files decode to FLOAT texels, the
+// rest to UNORM8.
+[[nodiscard]]
+auto load_image(const std::filesystem::path &path)
+    -> std::expected<image, std::string>;
+
+// allocates an uninitialized level
+[[nodiscard]]
+auto make_level(int width, int height, int channels,
+                block_format block = block_format::NONE,
+                pixel_type type = pixel_type::UNORM8) -> image::level;
+
+// number of levels of a full chain down to 1x1
+[[nodiscard]]
+auto mip_count(int width, int height) noexcept -> int;
+
+// appends the full mip chain below levels[0] using a 2x2 box filter, only
+// for UNORM8 and FLOAT images. sRGB images are filtered in linear light so
+// albedo does not darken towards the small mips.
+auto generate_mips(image &img) -> void;
+
+} // namespace derp
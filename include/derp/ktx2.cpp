@@ -0,0 +1,371 @@
+//===-- Implementation of KTX2 reader and writer --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ktx2.hpp"
+
+#include <algorithm>    // std::max, std::min
+#include <array>        // std::array
+#include <cstdint>      // uint8_t, uint32_t, uint64_t
+#include <fstream>      // std::ifstream, std::ofstream
+#include <numeric>      // std::lcm
+#include <system_error> // std::error_code
+#include <vector>       // std::vector
+
+namespace derp {
+
+namespace {
+
+constexpr std::array<uint8_t, 12> IDENTIFIER = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// the index's 64 bit fields sit at a 4 byte struct offset, pack to match
+#pragma pack(push, 1)
+struct header {
+  uint32_t vk_format;
+  uint32_t type_size;
+  uint32_t pixel_width;
+  uint32_t pixel_height;
+  uint32_t pixel_depth;
+  uint32_t layer_count;
+  uint32_t face_count;
+  uint32_t level_count;
+  uint32_t supercompression_scheme;
+
+  uint32_t dfd_byte_offset;
+  uint32_t dfd_byte_length;
+  uint32_t kvd_byte_offset;
+  uint32_t kvd_byte_length;
+  uint64_t sgd_byte_offset;
+  uint64_t sgd_byte_length;
+};
+#pragma pack(pop)
+static_assert(sizeof(header) == 68);
+
+struct level_index {
+  uint64_t byte_offset;
+  uint64_t byte_length;
+  uint64_t uncompressed_byte_length;
+};
+static_assert(sizeof(level_index) == 24);
+
+// VkFormat values
+struct format_info {
+  uint32_t vk_format;
+  int channels;
+  bool srgb;
+  block_format block = block_format::NONE;
+  pixel_type type = pixel_type::UNORM8;
+};
+
+constexpr auto NONE = block_format::NONE;
+
+constexpr std::array<format_info, 20> FORMATS = {{
+    {9, 1, false},  // VK_FORMAT_R8_UNORM
+    {15, 1, true},  // VK_FORMAT_R8_SRGB
+    {16, 2, false}, // VK_FORMAT_R8G8_UNORM
+    {22, 2, true},  // VK_FORMAT_R8G8_SRGB
+    {23, 3, false}, // VK_FORMAT_R8G8B8_UNORM
+    {29, 3, true},  // VK_FORMAT_R8G8B8_SRGB
+    {37, 4, false}, // VK_FORMAT_R8G8B8A8_UNORM
+    {43, 4, true},  // VK_FORMAT_R8G8B8A8_SRGB
+    {131, 3, false, block_format::BC1}, // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+    {132, 3, true, block_format::BC1},  // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+    {137, 4, false, block_format::BC3}, // VK_FORMAT_BC3_UNORM_BLOCK
+    {138, 4, true, block_format::BC3},  // VK_FORMAT_BC3_SRGB_BLOCK
+    {139, 1, false, block_format::BC4}, // VK_FORMAT_BC4_UNORM_BLOCK
+    {141, 2, false, block_format::BC5}, // VK_FORMAT_BC5_UNORM_BLOCK
+    {145, 4, false, block_format::BC7}, // VK_FORMAT_BC7_UNORM_BLOCK
+    {146, 4, true, block_format::BC7},  // VK_FORMAT_BC7_SRGB_BLOCK
+    {76, 1, false, NONE, pixel_type::HALF}, // VK_FORMAT_R16_SFLOAT
+    {83, 2, false, NONE, pixel_type::HALF}, // VK_FORMAT_R16G16_SFLOAT
+    {97, 4, false, NONE, pixel_type::HALF}, // VK_FORMAT_R16G16B16A16_SFLOAT
+    {122, 3, false, NONE,
+     pixel_type::R11G11B10F}, // VK_FORMAT_B10G11R11_UFLOAT_PACK32
+}};
+
+auto find_format(const image &img) -> const format_info * {
+  for (const auto &f : FORMATS) {
+    if (f.channels == img.channels && f.srgb == img.srgb &&
+        f.block == img.block && f.type == img.type)
+      return &f;
+  }
+  return nullptr;
+}
+
+auto find_format(const uint32_t vk_format) -> const format_info * {
+  for (const auto &f : FORMATS) {
+    if (f.vk_format == vk_format)
+      return &f;
+  }
+  return nullptr;
+}
+
+constexpr uint32_t KHR_DF_CHANNEL_ALPHA = 15;
+constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_SIGNED = 0x40;
+constexpr uint32_t KHR_DF_SAMPLE_DATATYPE_FLOAT = 0x80;
+
+// sampleLower and sampleUpper of float formats, as float bits
+constexpr uint32_t FLOAT_ONE = 0x3F800000;
+constexpr uint32_t FLOAT_MINUS_ONE = 0xBF800000;
+
+struct dfd_sample {
+  uint32_t offset; // bits
+  uint32_t length; // bits
+  uint32_t channel;
+  uint32_t upper;
+  uint32_t lower = 0;
+};
+
+// samples of an uncompressed format, one per channel
+auto texel_samples(const format_info &format) -> std::vector<dfd_sample> {
+  const auto channels = static_cast<uint32_t>(format.channels);
+  std::vector<dfd_sample> samples;
+
+  if (format.type == pixel_type::R11G11B10F) {
+    constexpr uint32_t F = KHR_DF_SAMPLE_DATATYPE_FLOAT;
+    return {{0, 11, 0 | F, FLOAT_ONE},
+            {11, 11, 1 | F, FLOAT_ONE},
+            {22, 10, 2 | F, FLOAT_ONE}};
+  }
+
+  for (uint32_t c = 0; c < channels; ++c) {
+    const bool alpha = (channels == 4 && c == 3) || (channels == 2 && c == 1);
+    uint32_t channel = alpha ? KHR_DF_CHANNEL_ALPHA : c;
+
+    if (format.type == pixel_type::HALF) {
+      channel |= KHR_DF_SAMPLE_DATATYPE_FLOAT | KHR_DF_SAMPLE_DATATYPE_SIGNED;
+      samples.push_back({c * 16, 16, channel, FLOAT_ONE, FLOAT_MINUS_ONE});
+      continue;
+    }
+
+    if (alpha && format.srgb)
+      channel |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+    samples.push_back({c * 8, 8, channel, 255});
+  }
+  return samples;
+}
+
+// samples of a block compressed format, each covers a whole 64 bit half (or
+// the full block) since the bits are not addressable per texel
+auto block_samples(const format_info &format) -> std::vector<dfd_sample> {
+  constexpr uint32_t FULL = 0xFFFFFFFF;
+  constexpr uint32_t KHR_DF_CHANNEL_RED = 0;
+  constexpr uint32_t KHR_DF_CHANNEL_GREEN = 1;
+  const uint32_t linear_alpha =
+      KHR_DF_CHANNEL_ALPHA | (format.srgb ? KHR_DF_SAMPLE_DATATYPE_LINEAR : 0);
+
+  switch (format.block) {
+  case block_format::BC3:
+    return {{0, 64, linear_alpha, FULL}, {64, 64, KHR_DF_CHANNEL_RED, FULL}};
+  case block_format::BC5:
+    return {{0, 64, KHR_DF_CHANNEL_RED, FULL},
+            {64, 64, KHR_DF_CHANNEL_GREEN, FULL}};
+  case block_format::BC7:
+    return {{0, 128, KHR_DF_CHANNEL_RED, FULL}};
+  default: // BC1, BC4
+    return {{0, 64, KHR_DF_CHANNEL_RED, FULL}};
+  }
+}
+
+// Khronos basic data format descriptor
+auto make_dfd(const format_info &format) -> std::vector<uint32_t> {
+  constexpr uint32_t KHR_DF_MODEL_RGBSDA = 1;
+  constexpr uint32_t KHR_DF_MODEL_BC1A = 128;
+  constexpr uint32_t KHR_DF_MODEL_BC3 = 130;
+  constexpr uint32_t KHR_DF_MODEL_BC4 = 131;
+  constexpr uint32_t KHR_DF_MODEL_BC5 = 132;
+  constexpr uint32_t KHR_DF_MODEL_BC7 = 134;
+  constexpr uint32_t KHR_DF_PRIMARIES_BT709 = 1;
+  constexpr uint32_t KHR_DF_TRANSFER_LINEAR = 1;
+  constexpr uint32_t KHR_DF_TRANSFER_SRGB = 2;
+
+  std::vector<dfd_sample> samples;
+  uint32_t model = KHR_DF_MODEL_RGBSDA;
+  uint32_t dimensions = 0; // texelBlockDimension, stored minus one
+  uint32_t bytes = 0;
+
+  if (format.block == block_format::NONE) {
+    samples = texel_samples(format);
+    bytes = static_cast<uint32_t>(pixel_bytes(format.channels, format.type));
+  } else {
+    switch (format.block) {
+    case block_format::BC1:
+      model = KHR_DF_MODEL_BC1A;
+      break;
+    case block_format::BC3:
+      model = KHR_DF_MODEL_BC3;
+      break;
+    case block_format::BC4:
+      model = KHR_DF_MODEL_BC4;
+      break;
+    case block_format::BC5:
+      model = KHR_DF_MODEL_BC5;
+      break;
+    default:
+      model = KHR_DF_MODEL_BC7;
+      break;
+    }
+    samples = block_samples(format);
+    dimensions = 3 | 3 << 8; // 4x4x1x1
+    bytes = static_cast<uint32_t>(block_bytes(format.block));
+  }
+
+  const auto block_size = static_cast<uint32_t>(24 + 16 * samples.size());
+
+  std::vector<uint32_t> dfd;
+  dfd.push_back(4 + block_size); // dfdTotalSize
+  dfd.push_back(0);              // vendorId = KHRONOS, descriptorType = 0
+  dfd.push_back(2 | block_size << 16); // versionNumber = 1.3
+  dfd.push_back(model | KHR_DF_PRIMARIES_BT709 << 8 |
+                (format.srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR)
+                    << 16);
+  dfd.push_back(dimensions);
+  dfd.push_back(bytes); // bytesPlane0
+  dfd.push_back(0);     // bytesPlane4..7
+
+  for (const auto &s : samples) {
+    dfd.push_back(s.offset | (s.length - 1) << 16 | s.channel << 24);
+    dfd.push_back(0);       // samplePosition
+    dfd.push_back(s.lower); // sampleLower
+    dfd.push_back(s.upper); // sampleUpper
+  }
+  return dfd;
+}
+
+constexpr auto align(const uint64_t value, const uint64_t alignment)
+    -> uint64_t {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+auto write_ktx2(const std::filesystem::path &path, const image &img) -> bool {
+  const auto *format = find_format(img);
+  if (!format || img.levels.empty())
+    return false;
+
+  const auto level_count = static_cast<uint32_t>(img.levels.size());
+  const auto dfd = make_dfd(*format);
+
+  header h{};
+  h.vk_format = format->vk_format;
+  // size of the data type, 1 for block compressed formats
+  h.type_size = img.type == pixel_type::HALF         ? 2
+                : img.type == pixel_type::R11G11B10F ? 4
+                                                     : 1;
+  h.pixel_width = static_cast<uint32_t>(img.levels.front().width);
+  h.pixel_height = static_cast<uint32_t>(img.levels.front().height);
+  h.face_count = 1;
+  h.level_count = level_count;
+  h.dfd_byte_offset = static_cast<uint32_t>(IDENTIFIER.size() + sizeof(h) +
+                                            level_count * sizeof(level_index));
+  h.dfd_byte_length = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+  // level data is stored smallest mip first, each aligned to
+  // lcm(texel block size, 4)
+  uint64_t alignment = std::lcm(pixel_bytes(img.channels, img.type), 4);
+  if (img.block != block_format::NONE)
+    alignment = block_bytes(img.block); // 8 or 16, already a multiple of 4
+  std::vector<level_index> index(level_count);
+  uint64_t offset = h.dfd_byte_offset + h.dfd_byte_length;
+  for (uint32_t i = level_count; i-- > 0;) {
+    offset = align(offset, alignment);
+    index[i] = {offset, img.levels[i].size, img.levels[i].size};
+    offset += img.levels[i].size;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream file{tmp, std::ios::binary | std::ios::trunc};
+    if (!file)
+      return false;
+
+    file.write(reinterpret_cast<const char *>(IDENTIFIER.data()),
+               IDENTIFIER.size());
+    file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    file.write(reinterpret_cast<const char *>(index.data()),
+               static_cast<std::streamsize>(index.size() *
+                                            sizeof(level_index)));
+    file.write(reinterpret_cast<const char *>(dfd.data()), h.dfd_byte_length);
+
+    for (uint32_t i = level_count; i-- > 0;) {
+      while (static_cast<uint64_t>(file.tellp()) < index[i].byte_offset)
+        file.put(0);
+      file.write(reinterpret_cast<const char *>(img.levels[i].pixels.get()),
+                 static_cast<std::streamsize>(img.levels[i].size));
+    }
+
+    if (!file)
+      return false;
+  }
+
+  std::filesystem::rename(tmp, path, ec);
+  return !ec;
+}
+
+auto read_ktx2(const std::filesystem::path &path, const uint32_t first_level,
+               uint32_t level_count) -> std::optional<image> {
+  std::ifstream file{path, std::ios::binary};
+  if (!file)
+    return std::nullopt;
+
+  std::array<uint8_t, IDENTIFIER.size()> identifier{};
+  header h{};
+  file.read(reinterpret_cast<char *>(identifier.data()), identifier.size());
+  file.read(reinterpret_cast<char *>(&h), sizeof(h));
+  if (!file || identifier != IDENTIFIER)
+    return std::nullopt;
+
+  const auto *format = find_format(h.vk_format);
+  if (!format || h.supercompression_scheme != 0 || h.pixel_depth != 0 ||
+      h.layer_count != 0 || h.face_count != 1 || h.level_count == 0)
+    return std::nullopt;
+
+  std::vector<level_index> index(h.level_count);
+  file.read(reinterpret_cast<char *>(index.data()),
+            static_cast<std::streamsize>(index.size() * sizeof(level_index)));
+  if (!file)
+    return std::nullopt;
+
+  if (first_level >= h.level_count)
+    return std::nullopt;
+  const uint32_t available = h.level_count - first_level;
+  level_count = level_count ? std::min(level_count, available) : available;
+
+  image img;
+  img.channels = format->channels;
+  img.srgb = format->srgb;
+  img.block = format->block;
+  img.type = format->type;
+  img.levels.reserve(level_count);
+
+  for (uint32_t i = first_level; i < first_level + level_count; ++i) {
+    const int w = std::max(1, static_cast<int>(h.pixel_width >> i));
+    const int ht = std::max(1, static_cast<int>(h.pixel_height >> i));
+    auto level = make_level(w, ht, img.channels, img.block, img.type);
+    if (index[i].byte_length != level.size)
+      return std::nullopt;
+
+    file.seekg(static_cast<std::streamoff>(index[i].byte_offset));
+    file.read(reinterpret_cast<char *>(level.pixels.get()),
+              static_cast<std::streamsize>(level.size));
+    if (!file)
+      return std::nullopt;
+
+    img.levels.push_back(std::move(level));
+  }
+  return img;
+}
+
+} // namespace derp
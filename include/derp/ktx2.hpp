@@ -0,0 +1,37 @@
+//===-- Implementation header for KTX2 reader and writer ------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+
+#include <cstdint>    // uint32_t
+#include <filesystem> // std::filesystem::path
+#include <optional>   // std::optional
+
+namespace derp {
+
+// Just enough of KTX 2.0 for the texture cache: one 2D image, no array
+// layers, no cube faces, no supercompression, any number of mip levels.
+// Levels are 8 bit, half float or R11G11B10F texels, or BC1/BC3/BC4/BC5/BC7
+// blocks.
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+
+// writes through a temporary file and renames it into place, so readers
+// never see a half written cache entry
+auto write_ktx2(const std::filesystem::path &path, const image &img) -> bool;
+
+// nothing if the file is missing, malformed or in a format we don't handle.
+// reads `level_count` levels (0 for all) starting at `first_level`, which
+// becomes levels[0] of the result.
+[[nodiscard]]
+auto read_ktx2(const std::filesystem::path &path, uint32_t first_level = 0,
+               uint32_t level_count = 0) -> std::optional<image>;
+
+} // namespace derp
@@ -0,0 +1,75 @@
+//===-- Implementation of mapped file class -------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "mapped_file.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close
+#define DERP_MMAP 1
+#else
+#include <fstream>  // std::ifstream
+#include <iterator> // std::istreambuf_iterator
+#endif
+
+namespace derp {
+
+mapped_file::mapped_file(const std::filesystem::path &path) {
+#ifdef DERP_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+
+  struct stat st{};
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    void *mapping = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                           PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping != MAP_FAILED) {
+      // decoders read front to back
+      ::madvise(mapping, static_cast<std::size_t>(st.st_size),
+                MADV_SEQUENTIAL);
+      bytes = static_cast<const unsigned char *>(mapping);
+      length = static_cast<std::size_t>(st.st_size);
+    }
+  }
+  // the mapping keeps the file alive on its own
+  ::close(fd);
+#else
+  std::ifstream file{path, std::ios::binary};
+  if (!file)
+    return;
+  fallback.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+  bytes = fallback.data();
+  length = fallback.size();
+#endif
+}
+
+mapped_file::~mapped_file() {
+#ifdef DERP_MMAP
+  if (bytes)
+    ::munmap(const_cast<unsigned char *>(bytes), length);
+#endif
+}
+
+mapped_file::operator bool() const noexcept { return length > 0; }
+
+auto mapped_file::data() const noexcept -> const unsigned char * {
+  return bytes;
+}
+
+auto mapped_file::size() const noexcept -> std::size_t { return length; }
+
+auto mapped_file::span() const noexcept -> std::span<const unsigned char> {
+  return {bytes, length};
+}
+
+} // namespace derp
@@ -0,0 +1,50 @@
+//===-- Implementation header for mapped file class -----------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>    // std::size_t
+#include <filesystem> // std::filesystem::path
+#include <span>       // std::span
+#include <vector>     // std::vector
+
+namespace derp {
+
+// Read only view of a whole file. On POSIX systems the file is mmapped, so
+// the kernel pages it in as the decoder walks it instead of copying it
+// through stdio buffers first. Elsewhere it falls back to reading the file
+// into memory once.
+class mapped_file {
+private:
+  const unsigned char *bytes = nullptr;
+  std::size_t length = 0;
+  std::vector<unsigned char> fallback; // owns the bytes without mmap
+
+public:
+  // an empty view if the file can't be opened, check with operator bool
+  explicit mapped_file(const std::filesystem::path &path);
+  ~mapped_file();
+
+  mapped_file(const mapped_file &) = delete;
+  mapped_file &operator=(const mapped_file &) = delete;
+
+  [[nodiscard]]
+  explicit operator bool() const noexcept;
+
+  [[nodiscard]]
+  auto data() const noexcept -> const unsigned char *;
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t;
+
+  [[nodiscard]]
+  auto span() const noexcept -> std::span<const unsigned char>;
+}; // class mapped_file
+
+} // namespace derp
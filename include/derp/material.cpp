@@ -0,0 +1,170 @@
+//===-- Implementation of material class ----------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "material.hpp"
+
+#include <fstream> // std::ifstream
+#include <print>   // std::println
+#include <sstream> // std::istringstream
+
+namespace derp {
+
+auto material_maps::normal_height() const -> channel_pack {
+  if (normal.empty() && height.empty())
+    return {};
+  // a missing normal map leaves a flat normal, a missing height map no
+  // displacement
+  return {.channels = {{{normal, 0, 128},
+                        {normal, 1, 128},
+                        {"", 0, 255},
+                        {height, 0, 255}}},
+          .count = 4};
+}
+
+auto material_maps::orm() const -> channel_pack {
+  if (occlusion.empty() && roughness.empty() && metallic.empty())
+    return {};
+  return {.channels = {{{occlusion, 0, 255},
+                        {roughness, 0, 255},
+                        {metallic, 0, 0}}},
+          .count = 3};
+}
+
+auto read_mtl(const std::filesystem::path &path)
+    -> std::expected<std::vector<material_maps>, std::string> {
+  std::ifstream file(path);
+  if (!file)
+    return std::unexpected("can't open file");
+
+  std::vector<material_maps> materials;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream tokens(line);
+    std::string key;
+    if (!(tokens >> key) || key.starts_with('#'))
+      continue;
+
+    if (key == "newmtl") {
+      materials.emplace_back();
+      tokens >> materials.back().name;
+      continue;
+    }
+    if (materials.empty())
+      continue;
+
+    // options like -bm 1.0 come first, the file name is the last token
+    std::string file_name;
+    for (std::string token; tokens >> token;)
+      file_name = std::move(token);
+    if (file_name.empty())
+      continue;
+
+    auto &m = materials.back();
+    std::string *map = nullptr;
+    if (key == "map_Kd")
+      map = &m.albedo;
+    else if (key == "map_bump" || key == "norm")
+      map = &m.normal;
+    else if (key == "bump" || key == "disp")
+      map = &m.height;
+    else if (key == "map_Ka" || key == "map_ao")
+      map = &m.occlusion;
+    else if (key == "map_Pr")
+      map = &m.roughness;
+    else if (key == "map_Pm")
+      map = &m.metallic;
+
+    if (map)
+      *map = (path.parent_path() / file_name).string();
+  }
+  return materials;
+}
+
+material::material(const material_maps &maps, texture_streamer &streamer,
+                   const storage kind)
+    : name(maps.name), kind(kind) {
+  using type = texture::texture_type;
+  const auto normal_height = maps.normal_height();
+  const auto orm = maps.orm();
+
+  if (kind == storage::TEXTURE_ARRAYS) {
+    packer = &streamer.get_packer();
+    if (!maps.albedo.empty())
+      packed[ALBEDO] = streamer.load_packed(maps.albedo, type::DIFFUSE);
+    if (!normal_height.empty())
+      packed[NORMAL_HEIGHT] =
+          streamer.load_packed(normal_height, type::NORMAL_HEIGHT);
+    if (!orm.empty())
+      packed[ORM] = streamer.load_packed(orm, type::ORM);
+  } else {
+    textures[ALBEDO] = maps.albedo.empty()
+                           ? std::make_shared<texture>(type::DIFFUSE)
+                           : streamer.load(maps.albedo, type::DIFFUSE);
+    textures[NORMAL_HEIGHT] =
+        normal_height.empty()
+            ? std::make_shared<texture>(type::NORMAL_HEIGHT)
+            : streamer.load(normal_height, type::NORMAL_HEIGHT);
+    textures[ORM] = orm.empty() ? std::make_shared<texture>(type::ORM)
+                                : streamer.load(orm, type::ORM);
+  }
+
+  std::println("[INFO] material {}: {} maps in {} textures", name,
+               !maps.albedo.empty() + !maps.normal.empty() +
+                   !maps.height.empty() + !maps.occlusion.empty() +
+                   !maps.roughness.empty() + !maps.metallic.empty(),
+               !maps.albedo.empty() + !normal_height.empty() + !orm.empty());
+}
+
+auto material::storage_for(const material_table::path p) noexcept
+    -> storage {
+  return p == material_table::path::BINDLESS ? storage::TEXTURES
+                                             : storage::TEXTURE_ARRAYS;
+}
+
+auto material::use(const uint32_t first) const -> void {
+  if (kind == storage::TEXTURE_ARRAYS) {
+    for (uint32_t i = 0; i < UNITS; ++i) {
+      if (const auto *slot = get_packed(static_cast<unit>(i)))
+        packer->use(slot->array, first + i);
+    }
+    return;
+  }
+
+  std::array<const texture *, UNITS> bound{};
+  for (std::size_t i = 0; i < textures.size(); ++i)
+    bound[i] = textures[i].get();
+  texture::use_all(first, bound);
+}
+
+auto material::request_mips(texture_streamer &streamer,
+                            const float uv_density,
+                            const float distance) const -> void {
+  for (const auto &tex : textures) {
+    if (tex)
+      streamer.request_mips(*tex, uv_density, distance);
+  }
+}
+
+auto material::get_name() const noexcept -> const std::string & {
+  return name;
+}
+
+auto material::get_storage() const noexcept -> storage { return kind; }
+
+auto material::get_texture(const unit u) const
+    -> const std::shared_ptr<texture> & {
+  return textures[u];
+}
+
+auto material::get_packed(const unit u) const -> const packed_texture * {
+  const auto &slot = packed[u];
+  return slot && slot->ready ? slot.get() : nullptr;
+}
+
+} // namespace derp
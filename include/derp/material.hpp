@@ -0,0 +1,113 @@
+//===-- Implementation header for material class --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "channel_pack.hpp"
+#include "material_table.hpp"
+#include "texture.hpp"
+#include "texture_packer.hpp"
+#include "texture_streamer.hpp"
+
+#include <array>      // std::array
+#include <cstdint>    // uint32_t
+#include <expected>   // std::expected
+#include <filesystem> // std::filesystem::path
+#include <memory>     // std::shared_ptr
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+namespace derp {
+
+// texture maps of one .mtl material, paths resolved against the .mtl file.
+// `bump` and `disp` are read as height maps, `map_bump` and `norm` as normal
+// maps, empty for maps the material doesn't have.
+struct material_maps {
+  std::string name;
+  std::string albedo;    // map_Kd
+  std::string normal;    // map_bump, norm
+  std::string height;    // bump, disp
+  std::string occlusion; // map_Ka, map_ao
+  std::string roughness; // map_Pr
+  std::string metallic;  // map_Pm
+
+  // packing of the normal and height maps, empty without either
+  [[nodiscard]]
+  auto normal_height() const -> channel_pack;
+
+  // packing of the occlusion, roughness and metalness maps, empty without
+  // any of them
+  [[nodiscard]]
+  auto orm() const -> channel_pack;
+};
+
+// reads the texture maps of every material in an .mtl file
+[[nodiscard]]
+auto read_mtl(const std::filesystem::path &path)
+    -> std::expected<std::vector<material_maps>, std::string>;
+
+// Textures of a material, with the single channel maps packed at import so
+// the fragment shader binds three textures and fetches each once:
+//
+//   unit 0  albedo                 sRGB
+//   unit 1  normal xy, height      z is rebuilt in the shader
+//   unit 2  occlusion, roughness, metalness
+//
+// Maps the material lacks sample as the unit's neutral placeholder, so one
+// shader (material.frag) handles every material.
+//
+// With TEXTURE_ARRAYS storage the maps land in the streamer's texture arrays
+// instead (see texture_packer), and the shader finds their layers through a
+// material_table. Packed maps keep every level and don't stream.
+class material {
+public:
+  enum unit : uint32_t { ALBEDO, NORMAL_HEIGHT, ORM, UNITS };
+  enum class storage { TEXTURES, TEXTURE_ARRAYS };
+
+private:
+  std::string name;
+  storage kind;
+  std::array<std::shared_ptr<texture>, UNITS> textures;
+  // TEXTURE_ARRAYS only, empty for maps the material lacks
+  std::array<std::shared_ptr<const packed_texture>, UNITS> packed;
+  const texture_packer *packer = nullptr;
+
+public:
+  material(const material_maps &maps, texture_streamer &streamer,
+           storage kind = storage::TEXTURES);
+
+  // what materials drawn through a material_table on `p` are made with
+  [[nodiscard]]
+  static auto storage_for(material_table::path p) noexcept -> storage;
+
+  // binds the textures, or the arrays holding them, to units
+  // [first, first + UNITS). arrays of maps not uploaded yet are skipped
+  auto use(uint32_t first = 0) const -> void;
+
+  // forwards to texture_streamer::request_mips() for every texture
+  auto request_mips(texture_streamer &streamer, float uv_density,
+                    float distance) const -> void;
+
+  [[nodiscard]]
+  auto get_name() const noexcept -> const std::string &;
+
+  [[nodiscard]]
+  auto get_storage() const noexcept -> storage;
+
+  // the texture of `u`, TEXTURES storage only
+  [[nodiscard]]
+  auto get_texture(unit u) const -> const std::shared_ptr<texture> &;
+
+  // where `u` was packed, nullptr without the map, until it is uploaded, and
+  // with TEXTURES storage
+  [[nodiscard]]
+  auto get_packed(unit u) const -> const packed_texture *;
+}; // class material
+
+} // namespace derp
@@ -0,0 +1,128 @@
+//===-- Implementation of material table class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "material_table.hpp"
+#include "material.hpp"
+
+#include <cstring>     // std::memcmp
+#include <format>      // std::format
+#include <span>        // std::span
+#include <stdexcept>   // std::runtime_error
+#include <type_traits> // std::extent_v
+
+namespace derp {
+
+static_assert(std::extent_v<decltype(material_data::rects)> == material::UNITS,
+              "material_data needs a rect per material unit");
+
+namespace {
+
+auto describe(const material &m) -> material_data {
+  material_data d{.maps = glm::uvec4(material_data::NO_MAP),
+                  .rects = {glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+                            glm::vec4(0.0f, 0.0f, 1.0f, 1.0f),
+                            glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)}};
+  for (uint32_t u = 0; u < material::UNITS; ++u) {
+    if (const auto *slot = m.get_packed(static_cast<material::unit>(u))) {
+      d.maps[static_cast<int>(u)] = slot->layer;
+      d.rects[u] = slot->uv_rect;
+    }
+  }
+  return d;
+}
+
+} // namespace
+
+auto material_table::choose() noexcept -> path {
+  return bindless_table::supported() ? path::BINDLESS : path::TEXTURE_ARRAYS;
+}
+
+material_table::material_table(const path kind, const std::size_t capacity)
+    : kind(kind), buffer(capacity) {
+  if (kind == path::BINDLESS)
+    bindless.emplace();
+  materials.reserve(capacity);
+  data.reserve(capacity);
+}
+
+auto material_table::add(const material &m) -> uint32_t {
+  if (m.get_storage() != material::storage_for(kind)) {
+    throw std::runtime_error(std::format(
+        "[ERROR] material {} has the wrong storage for the material table",
+        m.get_name()));
+  }
+  if (materials.size() == buffer.get_capacity()) {
+    throw std::runtime_error(
+        std::format("[ERROR] material table is full ({} materials)",
+                    buffer.get_capacity()));
+  }
+
+  auto d = describe(m);
+  if (bindless) {
+    // the table hands out placeholder handles until the texture streamed in
+    for (uint32_t u = 0; u < material::UNITS; ++u) {
+      d.maps[static_cast<int>(u)] =
+          bindless->add(m.get_texture(static_cast<material::unit>(u)));
+    }
+  }
+  materials.push_back(&m);
+  data.push_back(d);
+  dirty = true;
+  return static_cast<uint32_t>(materials.size() - 1);
+}
+
+auto material_table::mark_visible(const uint32_t index) -> void {
+  if (!bindless)
+    return;
+  for (uint32_t u = 0; u < material::UNITS; ++u)
+    bindless->mark_visible(data[index].maps[static_cast<int>(u)]);
+}
+
+auto material_table::update() -> void {
+  if (bindless) {
+    // the entries never move, only the handles behind them change
+    bindless->update();
+  } else {
+    refresh();
+  }
+  if (!dirty)
+    return;
+  dirty = false;
+  buffer.write(std::span<const material_data>(data));
+}
+
+auto material_table::refresh() -> void {
+  for (std::size_t i = 0; i < materials.size(); ++i) {
+    const auto d = describe(*materials[i]);
+    if (std::memcmp(&d, &data[i], sizeof(d)) != 0) {
+      data[i] = d;
+      dirty = true;
+    }
+  }
+}
+
+auto material_table::bind() const -> void {
+  buffer.bind();
+  if (bindless)
+    bindless->bind(HANDLES_BINDING);
+}
+
+auto material_table::use(const uint32_t index, const uint32_t first) const
+    -> void {
+  if (!bindless)
+    materials[index]->use(first);
+}
+
+auto material_table::get_path() const noexcept -> path { return kind; }
+
+auto material_table::size() const noexcept -> std::size_t {
+  return materials.size();
+}
+
+} // namespace derp
@@ -0,0 +1,109 @@
+//===-- Implementation header for material table class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "bindless_table.hpp"
+#include "typed_buffer.hpp"
+
+#include <array>       // std::array
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint32_t
+#include <optional>    // std::optional
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+#include <glm/glm.hpp>
+
+namespace derp {
+
+class material;
+
+// what shaders see of each material, indexed by the material's table index
+struct material_data {
+  static constexpr uint32_t NO_MAP = ~0u; // sample the map's neutral value
+
+  glm::uvec4 maps;    // per material unit: array layer or bindless index
+  glm::vec4 rects[3]; // uv_rect of each unit inside its layer
+};
+
+template <> struct block_traits<material_data> {
+  static constexpr std::string_view name = "material_data";
+  static constexpr std::string_view instance = "materials";
+  static constexpr uint32_t binding = 1;
+  static constexpr std::array fields{DERP_BLOCK_FIELD(material_data, maps),
+                                     DERP_BLOCK_FIELD(material_data, rects)};
+};
+
+// Where the maps of every material drawn with material.frag's TEXTURE_ARRAYS
+// or BINDLESS variant are. The shader gets a material's index through the
+// object (object_data.material in the demo) and looks its units up in the
+// "material_data.glsl" block, so materials draw without texture binds in
+// between, or with none at all.
+//
+// BINDLESS, picked by choose() when bindless_table::supported(), keeps the
+// material's textures in a bindless_table whose handles are bound at
+// HANDLES_BINDING; mark_visible() the materials about to be drawn. Without
+// the extension (llvmpipe, for one) it's TEXTURE_ARRAYS: materials' maps
+// are packed, and update() publishes the layers of the ones that finished
+// uploading. Until then, and for maps a material lacks, the layer is NO_MAP
+// and the shader uses the unit's neutral value. Materials are made with
+// material::storage_for(get_path()) and must outlive the table.
+class material_table {
+public:
+  enum class path { TEXTURE_ARRAYS, BINDLESS };
+
+  static constexpr std::size_t DEFAULT_CAPACITY = 256;
+  static constexpr uint32_t HANDLES_BINDING = 2;
+
+private:
+  path kind;
+  std::optional<bindless_table> bindless; // BINDLESS only
+  std::vector<const material *> materials;
+  std::vector<material_data> data; // mirror of the buffer's contents
+  storage_buffer<material_data> buffer;
+  bool dirty = false;
+
+  // TEXTURE_ARRAYS: picks up the layers of maps that finished uploading
+  auto refresh() -> void;
+
+public:
+  // BINDLESS if the driver has the extension, TEXTURE_ARRAYS if not
+  [[nodiscard]]
+  static auto choose() noexcept -> path;
+
+  explicit material_table(path kind = choose(),
+                          std::size_t capacity = DEFAULT_CAPACITY);
+
+  // returns the index shaders look `m` up with. throws std::runtime_error
+  // if the table is full or `m` has the wrong storage for the path
+  [[nodiscard]]
+  auto add(const material &m) -> uint32_t;
+
+  // keeps the textures of material `index` resident, BINDLESS only
+  auto mark_visible(uint32_t index) -> void;
+
+  // publishes maps that finished uploading or changed residency, once a
+  // frame before the draws
+  auto update() -> void;
+
+  auto bind() const -> void;
+
+  // binds the arrays holding the maps of material `index` to units
+  // [first, first + material::UNITS), nothing with BINDLESS
+  auto use(uint32_t index, uint32_t first = 0) const -> void;
+
+  [[nodiscard]]
+  auto get_path() const noexcept -> path;
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t;
+}; // class material_table
+
+} // namespace derp
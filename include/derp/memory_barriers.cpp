@@ -0,0 +1,62 @@
+//===-- Implementation of memory barrier tracker class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "memory_barriers.hpp"
+
+#include <iterator> // std::next
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+auto resource_key(const gpu_resource kind, const uint32_t id) -> uint64_t {
+  return uint64_t{static_cast<uint32_t>(kind)} << 32 | id;
+}
+
+} // namespace
+
+auto memory_barriers::shared() -> memory_barriers & {
+  static memory_barriers barriers;
+  return barriers;
+}
+
+auto memory_barriers::wrote(const gpu_resource kind, const uint32_t id)
+    -> void {
+  pending.insert_or_assign(resource_key(kind, id), GL_ALL_BARRIER_BITS);
+}
+
+auto memory_barriers::need(const gpu_resource kind, const uint32_t id,
+                           const uint32_t bits) -> void {
+  if (pending.empty())
+    return;
+  if (const auto it = pending.find(resource_key(kind, id));
+      it != pending.end())
+    needed |= it->second & bits;
+}
+
+auto memory_barriers::flush() -> void {
+  if (!needed)
+    return;
+  glMemoryBarrier(needed);
+  // every write so far is visible to these accesses now
+  for (auto it = pending.begin(); it != pending.end();) {
+    it->second &= ~needed;
+    it = it->second ? std::next(it) : pending.erase(it);
+  }
+  needed = 0;
+}
+
+auto memory_barriers::forget(const gpu_resource kind, const uint32_t id)
+    -> void {
+  pending.erase(resource_key(kind, id));
+}
+
+} // namespace derp
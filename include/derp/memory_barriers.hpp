@@ -0,0 +1,58 @@
+//===-- Implementation header for memory barrier tracker class ------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>       // uint32_t, uint64_t
+#include <unordered_map> // std::unordered_map
+
+namespace derp {
+
+// buffer and texture names are separate namespaces
+enum class gpu_resource : uint32_t { BUFFER, TEXTURE };
+
+// Which glMemoryBarrier bits the next access of a resource needs.
+//
+// Shader storage and image stores are incoherent: a later access only sees
+// them after a glMemoryBarrier with the bit of that kind of access. Producers
+// report what they wrote with wrote(), consumers say how they are about to
+// read with need() and issue the barrier with flush(). A barrier covers every
+// write before it, so each bit is issued once per batch of writes, and not at
+// all for resources nothing wrote.
+class memory_barriers {
+private:
+  // resource, the access bits its last write hasn't been made visible to
+  std::unordered_map<uint64_t, uint32_t> pending;
+  uint32_t needed = 0; // bits the next flush() issues
+
+  memory_barriers() = default;
+
+public:
+  memory_barriers(const memory_barriers &) = delete;
+  memory_barriers &operator=(const memory_barriers &) = delete;
+
+  // the tracker of the one context, render thread only
+  [[nodiscard]]
+  static auto shared() -> memory_barriers &;
+
+  // a shader wrote `id` through a storage block or an image store
+  auto wrote(gpu_resource kind, uint32_t id) -> void;
+
+  // `id` is about to be accessed as `bits` (GL_*_BARRIER_BIT)
+  auto need(gpu_resource kind, uint32_t id, uint32_t bits) -> void;
+
+  // one glMemoryBarrier for everything need()ed since the last flush, none if
+  // nothing was
+  auto flush() -> void;
+
+  // call before deleting the object
+  auto forget(gpu_resource kind, uint32_t id) -> void;
+}; // class memory_barriers
+
+} // namespace derp
@@ -9,14 +9,21 @@
 
 #pragma once
 
+#include "gl_state.hpp"
+#include "uniform_shadow.hpp"
+
 #include <glad/glad.h>
 
+#include "glm/common.hpp"
+#include "glm/geometric.hpp"
 #include "glm/vec2.hpp"
 #include "glm/vec3.hpp"
 
 #include "rapidobj/rapidobj.hpp"
 
+#include <cmath>
 #include <format>
+#include <limits>
 #include <numeric>
 #include <print>
 #include <unordered_map>
@@ -89,9 +96,17 @@ public:
     }
   };
 
+  // object space axis aligned bounding box
+  struct bounds {
+    glm::vec3 min{std::numeric_limits<float>::max()};
+    glm::vec3 max{std::numeric_limits<float>::lowest()};
+  };
+
 private:
   std::vector<vertex> vertices;
   std::vector<uint32_t> indices;
+  bounds aabb{};
+  float uv_density = 0.0f;
 
   uint32_t vao{};
   uint32_t vbo{};
@@ -103,6 +118,28 @@ public:
 
   mesh(std::vector<vertex> &&vertices, std::vector<uint32_t> &&indices)
       : vertices(std::move(vertices)), indices(std::move(indices)) {
+    for (const auto &v : this->vertices) {
+      aabb.min = glm::min(aabb.min, v.position);
+      aabb.max = glm::max(aabb.max, v.position);
+    }
+
+    // area weighted over all triangles, so a few stretched ones don't
+    // dominate
+    double world_area = 0.0;
+    double uv_area = 0.0;
+    for (size_t i = 0; i + 2 < this->indices.size(); i += 3) {
+      const auto &a = this->vertices[this->indices[i]];
+      const auto &b = this->vertices[this->indices[i + 1]];
+      const auto &c = this->vertices[this->indices[i + 2]];
+      world_area += glm::length(
+          glm::cross(b.position - a.position, c.position - a.position));
+      const auto e0 = b.uv - a.uv;
+      const auto e1 = c.uv - a.uv;
+      uv_area += std::abs(e0.x * e1.y - e0.y * e1.x);
+    }
+    if (world_area > 0.0)
+      uv_density = static_cast<float>(std::sqrt(uv_area / world_area));
+
     glCreateVertexArrays(1, &vao);
 
     glCreateBuffers(1, &vbo);
@@ -138,20 +175,32 @@ public:
       glDeleteBuffers(1, &ibo);
     if (vbo)
       glDeleteBuffers(1, &vbo);
-    if (vao)
+    if (vao) {
+      gl_state::shared().forget_vertex_array(vao);
       glDeleteVertexArrays(1, &vao);
+    }
   }
 
-  void use() const { glBindVertexArray(vao); }
+  [[nodiscard]] const bounds &get_bounds() const { return aabb; }
+
+  // average UV units per object space unit, what the texture streamer needs
+  // to turn a distance into a mip level
+  [[nodiscard]] float get_uv_density() const { return uv_density; }
+
+  void use() const { gl_state::shared().bind_vertex_array(vao); }
 
-  void draw() const {
-    glDrawElements(GL_TRIANGLES, static_cast<int>(indices.size()),
-                   GL_UNSIGNED_INT, nullptr);
+  // `object` reaches the shader as gl_BaseInstance, the index of the
+  // object's entry in a storage_buffer
+  void draw(const uint32_t object = 0) const {
+    uniform_shadow::flush_all();
+    glDrawElementsInstancedBaseInstance(
+        GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT,
+        nullptr, 1, object);
   }
 
-  void use_and_draw() const {
+  void use_and_draw(const uint32_t object = 0) const {
     use();
-    draw();
+    draw(object);
   }
 
   static auto from_obj(const std::string &filepath) {
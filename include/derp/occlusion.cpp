@@ -0,0 +1,146 @@
+//===-- Implementation of occlusion culler class --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "occlusion.hpp"
+
+#include "glm/common.hpp"
+#include "glm/ext/matrix_transform.hpp"
+#include "glm/vector_relational.hpp"
+
+#include <limits> // std::numeric_limits
+
+namespace derp {
+
+namespace {
+
+auto make_unit_cube() -> mesh {
+  const auto *vertex_data =
+      reinterpret_cast<const mesh::vertex *>(cube_vertices);
+  std::vector vertices(vertex_data, vertex_data + 24);
+  std::vector indices(std::begin(cube_indices), std::end(cube_indices));
+  return {std::move(vertices), std::move(indices)};
+}
+
+} // namespace
+
+occlusion_culler::occlusion_culler() : occlusion_culler(hysteresis{}) {}
+
+occlusion_culler::occlusion_culler(const hysteresis policy)
+    : policy(policy), proxy(make_unit_cube()),
+      proxy_shader(RESOURCES_PATH "/shaders/light_cube.vert",
+                   RESOURCES_PATH "/shaders/light_cube.frag") {}
+
+occlusion_culler::~occlusion_culler() {
+  for (auto &obj : objects) {
+    glDeleteQueries(QUERY_LATENCY, obj.queries.data());
+  }
+}
+
+auto occlusion_culler::add() -> uint32_t {
+  auto &obj = objects.emplace_back();
+  glCreateQueries(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, QUERY_LATENCY,
+                  obj.queries.data());
+  return static_cast<uint32_t>(objects.size() - 1);
+}
+
+auto occlusion_culler::resolve(object &obj, const uint32_t slot) -> void {
+  if (!obj.pending[slot])
+    return;
+
+  uint32_t available = GL_FALSE;
+  glGetQueryObjectuiv(obj.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available)
+    return;
+
+  uint32_t any_samples = GL_FALSE;
+  glGetQueryObjectuiv(obj.queries[slot], GL_QUERY_RESULT, &any_samples);
+  obj.pending[slot] = false;
+
+  if (any_samples) {
+    obj.occluded_frames = 0;
+    obj.visible = true;
+  } else if (++obj.occluded_frames >= policy.hide_after) {
+    obj.visible = false;
+  }
+}
+
+auto occlusion_culler::begin_frame(const glm::mat4 &view,
+                                   const glm::mat4 &projection,
+                                   const glm::vec3 &eye_position) -> void {
+  // oldest slot first so the hysteresis sees results in issue order
+  for (auto &obj : objects) {
+    for (uint32_t i = 1; i <= QUERY_LATENCY; ++i) {
+      resolve(obj, (frame + i) % QUERY_LATENCY);
+    }
+    obj.current = 0;
+  }
+
+  ++frame;
+  eye = eye_position;
+
+  proxy_shader.use();
+  proxy_shader["u_view"] = view;
+  proxy_shader["u_projection"] = projection;
+}
+
+auto occlusion_culler::test(const uint32_t id, const mesh::bounds &bounds,
+                            const glm::mat4 &model) -> void {
+  auto &obj = objects[id];
+
+  // world space box of the transformed corners, conservative under rotation
+  glm::vec3 lo{std::numeric_limits<float>::max()};
+  glm::vec3 hi{std::numeric_limits<float>::lowest()};
+  for (uint32_t corner = 0; corner < 8; ++corner) {
+    const glm::vec3 p{(corner & 1) ? bounds.max.x : bounds.min.x,
+                      (corner & 2) ? bounds.max.y : bounds.min.y,
+                      (corner & 4) ? bounds.max.z : bounds.min.z};
+    const glm::vec3 world{model * glm::vec4(p, 1.0f)};
+    lo = glm::min(lo, world);
+    hi = glm::max(hi, world);
+  }
+
+  const glm::vec3 margin{policy.eye_margin};
+  if (glm::all(glm::greaterThanEqual(eye, lo - margin)) &&
+      glm::all(glm::lessThanEqual(eye, hi + margin))) {
+    obj.occluded_frames = 0;
+    obj.visible = true;
+    return;
+  }
+
+  // the GPU is QUERY_LATENCY frames behind, keep the last known state
+  const uint32_t slot = frame % QUERY_LATENCY;
+  if (obj.pending[slot])
+    return;
+
+  const auto center = (lo + hi) * 0.5f;
+  const auto proxy_model =
+      glm::scale(glm::translate(glm::identity<glm::mat4>(), center), hi - lo);
+
+  proxy_shader.use();
+  proxy_shader["u_model"] = proxy_model;
+
+  glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+  glDepthMask(GL_FALSE);
+
+  glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, obj.queries[slot]);
+  proxy.use_and_draw();
+  glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+
+  glDepthMask(GL_TRUE);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+  obj.pending[slot] = true;
+  obj.current = obj.queries[slot];
+}
+
+auto occlusion_culler::is_visible(const uint32_t id) const -> bool {
+  return objects[id].visible;
+}
+
+} // namespace derp
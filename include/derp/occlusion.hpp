@@ -0,0 +1,117 @@
+//===-- Implementation header for occlusion culler class ------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "mesh.hpp"
+#include "shader.hpp"
+
+#include <array>   // std::array
+#include <cstdint> // uint32_t
+#include <utility> // std::forward
+#include <vector>  // std::vector
+
+#include <glad/glad.h>
+
+#include "glm/mat4x4.hpp"
+#include "glm/vec3.hpp"
+
+namespace derp {
+
+// Temporal hardware occlusion culling for large occludees.
+//
+// Every frame each registered object draws its bounding box as a depth-only
+// proxy inside a GL_ANY_SAMPLES_PASSED_CONSERVATIVE query. The real draw is
+// then wrapped in a conditional render on that query, so the GPU drops it
+// without the CPU ever waiting. Results of older queries are read back a few
+// frames later (only once available, never stalling) and, after enough
+// consecutive occluded results, the object is skipped on the CPU entirely.
+//
+// Usage per frame:
+//   culler.begin_frame(view, projection, eye);
+//   ... draw occluders ...
+//   culler.test(id, mesh.get_bounds(), model);
+//   s.use(); // test() leaves the proxy program bound
+//   culler.draw(id, [&] { mesh.use_and_draw(); });
+class occlusion_culler {
+public:
+  struct hysteresis {
+    // consecutive occluded read backs before the draw is skipped on the CPU.
+    // objects become visible again on the first visible read back.
+    uint32_t hide_after = 4;
+    // world space slack around the box, keeps the near plane from clipping the
+    // proxy away while the camera is right next to (or inside) the object.
+    float eye_margin = 0.25f;
+  };
+
+private:
+  // queries in flight per object, i.e. how many frames the read back may lag
+  static constexpr uint32_t QUERY_LATENCY = 3;
+
+  struct object {
+    std::array<uint32_t, QUERY_LATENCY> queries{};
+    std::array<bool, QUERY_LATENCY> pending{};
+    uint32_t current = 0; // query issued this frame, 0 if none
+    uint32_t occluded_frames = 0;
+    bool visible = true;
+  };
+
+  std::vector<object> objects;
+  uint32_t frame = 0;
+  hysteresis policy;
+  glm::vec3 eye{};
+
+  mesh proxy;
+  shader proxy_shader;
+
+  auto resolve(object &obj, uint32_t slot) -> void;
+
+public:
+  occlusion_culler();
+  explicit occlusion_culler(hysteresis policy);
+  ~occlusion_culler();
+
+  occlusion_culler(const occlusion_culler &) = delete;
+  occlusion_culler &operator=(const occlusion_culler &) = delete;
+
+  // registers an occludee and allocates its query pool
+  [[nodiscard]]
+  auto add() -> uint32_t;
+
+  // collects finished results of earlier frames, never blocks
+  auto begin_frame(const glm::mat4 &view, const glm::mat4 &projection,
+                   const glm::vec3 &eye_position) -> void;
+
+  // issues the bounding box proxy query for this frame, call after occluders
+  auto test(uint32_t id, const mesh::bounds &bounds, const glm::mat4 &model)
+      -> void;
+
+  [[nodiscard]]
+  auto is_visible(uint32_t id) const -> bool;
+
+  template <typename F> auto draw(uint32_t id, F &&draw_fn) const -> void;
+}; // class occlusion_culler
+
+template <typename F>
+auto occlusion_culler::draw(const uint32_t id, F &&draw_fn) const -> void {
+  const auto &obj = objects[id];
+  if (!obj.visible)
+    return;
+
+  if (!obj.current) {
+    std::forward<F>(draw_fn)();
+    return;
+  }
+
+  glBeginConditionalRender(obj.current, GL_QUERY_NO_WAIT);
+  std::forward<F>(draw_fn)();
+  glEndConditionalRender();
+}
+
+} // namespace derp
@@ -0,0 +1,87 @@
+//===-- Implementation of pipeline cache class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "pipeline_cache.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm> // std::max
+#include <format>    // std::format
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+auto pair_key(const uint32_t vert, const uint32_t frag) -> uint64_t {
+  return uint64_t{vert} << 32 | frag;
+}
+
+} // namespace
+
+auto pipeline_cache::shared() -> pipeline_cache & {
+  static pipeline_cache cache;
+  return cache;
+}
+
+auto pipeline_cache::get(const shader &vert, const shader &frag) -> uint32_t {
+  const auto key = pair_key(vert.get_id(), frag.get_id());
+  if (const auto it = pipelines.find(key); it != pipelines.end())
+    return it->second;
+
+  uint32_t pipeline = 0;
+  glCreateProgramPipelines(1, &pipeline);
+  glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, vert.get_id());
+  glUseProgramStages(pipeline, GL_FRAGMENT_SHADER_BIT, frag.get_id());
+
+#ifndef NDEBUG
+  // catches stage interfaces that don't line up
+  glValidateProgramPipeline(pipeline);
+  int success = 0;
+  glGetProgramPipelineiv(pipeline, GL_VALIDATE_STATUS, &success);
+  if (!success) {
+    int length = 0;
+    glGetProgramPipelineiv(pipeline, GL_INFO_LOG_LENGTH, &length);
+    std::string log(std::max(length, 1), '\0');
+    glGetProgramPipelineInfoLog(pipeline, length, nullptr, log.data());
+    glDeleteProgramPipelines(1, &pipeline);
+    throw std::runtime_error(
+        std::format("[ERROR] program pipeline ({}, {}) is invalid:\n{}",
+                    vert.get_id(), frag.get_id(), log));
+  }
+#endif
+
+  pipelines.emplace(key, pipeline);
+  return pipeline;
+}
+
+auto pipeline_cache::bind(const shader &vert, const shader &frag) -> void {
+  auto &state = gl_state::shared();
+  state.verify();
+  state.bind_pipeline(get(vert, frag));
+}
+
+auto pipeline_cache::forget(const uint32_t program) -> void {
+  std::erase_if(pipelines, [program](const auto &entry) {
+    const auto [key, pipeline] = entry;
+    if (key >> 32 != program && (key & 0xFFFFFFFFu) != program)
+      return false;
+    gl_state::shared().forget_pipeline(pipeline);
+    glDeleteProgramPipelines(1, &pipeline);
+    return true;
+  });
+}
+
+auto pipeline_cache::size() const noexcept -> std::size_t {
+  return pipelines.size();
+}
+
+} // namespace derp
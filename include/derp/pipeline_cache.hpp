@@ -0,0 +1,57 @@
+//===-- Implementation header for pipeline cache class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "shader.hpp"
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // uint32_t, uint64_t
+#include <unordered_map> // std::unordered_map
+
+namespace derp {
+
+// Program pipelines made of separable programs, one per vertex + fragment
+// pair.
+//
+// Separable programs link one stage each, so N vertex and M fragment variants
+// cost N + M programs instead of N * M; the pairing happens here, on first
+// use, and is kept until either program goes away. Interfaces between the
+// stages have to match by layout(location = N), names aren't matched across
+// programs. A pipeline is deleted with the first of its programs, there is
+// nothing to release at exit.
+class pipeline_cache {
+private:
+  std::unordered_map<uint64_t, uint32_t> pipelines; // stage pair, pipeline
+
+  pipeline_cache() = default;
+
+public:
+  pipeline_cache(const pipeline_cache &) = delete;
+  pipeline_cache &operator=(const pipeline_cache &) = delete;
+
+  // the pipelines of the one context, render thread only
+  [[nodiscard]]
+  static auto shared() -> pipeline_cache &;
+
+  // the pipeline running `vert` and `frag`, made on the first call
+  [[nodiscard]]
+  auto get(const shader &vert, const shader &frag) -> uint32_t;
+
+  // binds that pipeline through gl_state
+  auto bind(const shader &vert, const shader &frag) -> void;
+
+  // deletes every pipeline using `program`, call before deleting it
+  auto forget(uint32_t program) -> void;
+
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t;
+}; // class pipeline_cache
+
+} // namespace derp
@@ -0,0 +1,307 @@
+//===-- Implementation of pixel conversion --------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "pixel_convert.hpp"
+
+#include <algorithm>  // std::clamp, std::min
+#include <bit>        // std::bit_cast
+#include <cstdint>    // uint32_t
+#include <functional> // std::function
+#include <span>       // std::span
+#include <vector>     // std::vector
+
+// the SIMD paths are picked at runtime, the build does not need -mavx2
+#if (defined(__x86_64__) || defined(__i386__)) &&                             \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DERP_X86_DISPATCH 1
+#endif
+
+namespace derp {
+
+namespace {
+
+constexpr float HALF_MAX = 65504.0f;
+
+// largest finite values of the 11 and 10 bit floats, as half bit patterns
+constexpr uint32_t FLOAT11_MAX = 0x7BF0; // 65024
+constexpr uint32_t FLOAT10_MAX = 0x7BE0; // 64512
+
+auto float_to_half(float value) -> uint16_t {
+  value = std::clamp(value, -HALF_MAX, HALF_MAX); // NaN passes through
+  const auto bits = std::bit_cast<uint32_t>(value);
+  const uint32_t sign = (bits >> 16) & 0x8000;
+  const uint32_t abs = bits & 0x7FFFFFFF;
+
+  if (abs > 0x7F800000) // NaN
+    return static_cast<uint16_t>(sign | 0x7E00);
+
+  if (abs < 0x38800000) { // below the smallest normal half
+    if (abs < 0x33000000)
+      return static_cast<uint16_t>(sign);
+    const uint32_t shift = 126 - (abs >> 23);
+    const uint32_t mantissa = (abs & 0x7FFFFF) | 0x800000;
+    uint32_t h = mantissa >> shift;
+    const uint32_t rest = mantissa & ((1u << shift) - 1);
+    const uint32_t tie = 1u << (shift - 1);
+    if (rest > tie || (rest == tie && (h & 1)))
+      ++h;
+    return static_cast<uint16_t>(sign | h);
+  }
+
+  // rebias the exponent, a carry out of the mantissa bumps it as it should
+  uint32_t h = (abs >> 13) - (112 << 10);
+  const uint32_t rest = abs & 0x1FFF;
+  if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+    ++h;
+  return static_cast<uint16_t>(sign | h);
+}
+
+// drops the low mantissa bits of a non-negative half, rounding to nearest
+// even
+auto narrow_half(uint32_t h, const uint32_t max, const uint32_t bits)
+    -> uint32_t {
+  h = std::min(h & 0x7FFF, max);
+  const uint32_t round = (1u << (bits - 1)) - 1 + ((h >> bits) & 1);
+  return (h + round) >> bits;
+}
+
+#ifdef DERP_X86_DISPATCH
+auto has_avx2() -> bool {
+  static const bool supported = __builtin_cpu_supports("avx2") &&
+                                __builtin_cpu_supports("f16c");
+  return supported;
+}
+
+__attribute__((target("avx2,f16c"))) auto
+to_half_f16c(const float *src, uint16_t *dst, const std::size_t count)
+    -> std::size_t {
+  const __m256 hi = _mm256_set1_ps(HALF_MAX);
+  const __m256 lo = _mm256_set1_ps(-HALF_MAX);
+
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    // min/max return their second operand on NaN, keep the value there so
+    // NaN passes through like it does in float_to_half
+    const __m256 v =
+        _mm256_max_ps(lo, _mm256_min_ps(hi, _mm256_loadu_ps(src + i)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i),
+                     _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) auto
+pad_rgb_avx2(const uint8_t *src, uint8_t *dst, const std::size_t pixels)
+    -> std::size_t {
+  // each lane spreads 4 pixels over 16 bytes, the 4th byte comes from alpha
+  const __m256i spread =
+      _mm256_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+                       0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+  // the upper lane reads 16 bytes for its 12, stop before that runs off
+  std::size_t i = 0;
+  for (; i + 10 <= pixels; i += 8) {
+    const auto *in = src + i * 3;
+    const __m256i v = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 12)), 1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i * 4),
+                        _mm256_or_si256(_mm256_shuffle_epi8(v, spread),
+                                        alpha));
+  }
+  return i;
+}
+#endif
+
+using row_runner = std::function<void(uint32_t, const std::function<void(
+                                                    uint32_t)> &)>;
+
+enum class target { KEEP, RGBA8, HALF, RGBA16F, R11G11B10F };
+
+auto choose_target(const image &img) -> target {
+  const auto &base = img.levels.front();
+
+  if (img.type == pixel_type::UNORM8) {
+    if (img.channels == 3 || (img.srgb && img.channels < 3))
+      return target::RGBA8;
+    return target::KEEP;
+  }
+  if (img.type != pixel_type::FLOAT)
+    return target::KEEP;
+
+  const std::span texels{reinterpret_cast<const float *>(base.pixels.get()),
+                         base.size / sizeof(float)};
+  const auto n = static_cast<std::size_t>(img.channels);
+
+  // mips are averages of the base, they can't go negative on their own
+  bool unsigned_rgb = true;
+  bool opaque = true;
+  for (std::size_t i = 0; i < texels.size(); i += n) {
+    for (std::size_t c = 0; c < std::min<std::size_t>(n, 3); ++c)
+      unsigned_rgb = unsigned_rgb && texels[i + c] >= 0.0f; // NaN fails too
+    if (n == 4)
+      opaque = opaque && texels[i + 3] == 1.0f;
+  }
+
+  if (img.channels == 3)
+    return unsigned_rgb ? target::R11G11B10F : target::RGBA16F;
+  if (img.channels == 4)
+    return unsigned_rgb && opaque ? target::R11G11B10F : target::HALF;
+  return target::HALF;
+}
+
+auto convert_row(const target to, const int channels, const uint8_t *src,
+                 uint8_t *dst, const std::size_t width) -> void {
+  const auto n = static_cast<std::size_t>(channels);
+
+  switch (to) {
+  case target::RGBA8:
+    if (channels == 3) {
+      pad_rgb(src, dst, width);
+      return;
+    }
+    // grey or grey + alpha
+    for (std::size_t x = 0; x < width; ++x) {
+      const uint8_t v = src[x * n];
+      dst[x * 4] = dst[x * 4 + 1] = dst[x * 4 + 2] = v;
+      dst[x * 4 + 3] = channels == 2 ? src[x * n + 1] : 255;
+    }
+    return;
+
+  case target::HALF:
+    to_half(reinterpret_cast<const float *>(src),
+            reinterpret_cast<uint16_t *>(dst), width * n);
+    return;
+
+  case target::RGBA16F: {
+    thread_local std::vector<float> padded;
+    padded.resize(width * 4);
+    const auto *in = reinterpret_cast<const float *>(src);
+    for (std::size_t x = 0; x < width; ++x) {
+      for (std::size_t c = 0; c < 3; ++c)
+        padded[x * 4 + c] = in[x * 3 + c];
+      padded[x * 4 + 3] = 1.0f;
+    }
+    to_half(padded.data(), reinterpret_cast<uint16_t *>(dst), width * 4);
+    return;
+  }
+
+  case target::R11G11B10F: {
+    // through half so the rounding comes from the fast path as well
+    thread_local std::vector<uint16_t> halves;
+    halves.resize(width * n);
+    to_half(reinterpret_cast<const float *>(src), halves.data(), width * n);
+    auto *out = reinterpret_cast<uint32_t *>(dst);
+    for (std::size_t x = 0; x < width; ++x) {
+      const auto *h = &halves[x * n];
+      out[x] = narrow_half(h[0], FLOAT11_MAX, 4) |
+               narrow_half(h[1], FLOAT11_MAX, 4) << 11 |
+               narrow_half(h[2], FLOAT10_MAX, 5) << 22;
+    }
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+auto convert(image &img, const row_runner &rows) -> void {
+  if (img.block != block_format::NONE || img.levels.empty())
+    return;
+
+  const auto to = choose_target(img);
+  if (to == target::KEEP)
+    return;
+
+  int channels = img.channels;
+  pixel_type type = img.type;
+  switch (to) {
+  case target::RGBA8:
+    channels = 4;
+    break;
+  case target::HALF:
+    type = pixel_type::HALF;
+    break;
+  case target::RGBA16F:
+    channels = 4;
+    type = pixel_type::HALF;
+    break;
+  default:
+    channels = 3;
+    type = pixel_type::R11G11B10F;
+    break;
+  }
+
+  const auto src_texel = pixel_bytes(img.channels, img.type);
+  const auto dst_texel = pixel_bytes(channels, type);
+
+  for (auto &level : img.levels) {
+    auto out = make_level(level.width, level.height, channels,
+                          block_format::NONE, type);
+    const auto width = static_cast<std::size_t>(level.width);
+
+    rows(static_cast<uint32_t>(level.height), [&](const uint32_t y) {
+      convert_row(to, img.channels, level.pixels.get() + y * width * src_texel,
+                  out.pixels.get() + y * width * dst_texel, width);
+    });
+    level = std::move(out);
+  }
+
+  img.channels = channels;
+  img.type = type;
+  if (type != pixel_type::UNORM8)
+    img.srgb = false; // floats are linear
+}
+
+} // namespace
+
+auto negotiate_format(image &img, thread_pool &pool) -> void {
+  convert(img, [&](const uint32_t count, const auto &fn) {
+    pool.parallel_for(count, fn);
+  });
+}
+
+auto negotiate_format(image &img) -> void {
+  convert(img, [](const uint32_t count, const auto &fn) {
+    for (uint32_t i = 0; i < count; ++i)
+      fn(i);
+  });
+}
+
+auto to_half(const float *src, uint16_t *dst, const std::size_t count)
+    -> void {
+  std::size_t i = 0;
+#ifdef DERP_X86_DISPATCH
+  if (has_avx2())
+    i = to_half_f16c(src, dst, count);
+#endif
+  for (; i < count; ++i)
+    dst[i] = float_to_half(src[i]);
+}
+
+auto pad_rgb(const uint8_t *src, uint8_t *dst, const std::size_t pixels)
+    -> void {
+  std::size_t i = 0;
+#ifdef DERP_X86_DISPATCH
+  if (has_avx2())
+    i = pad_rgb_avx2(src, dst, pixels);
+#endif
+  for (; i < pixels; ++i) {
+    dst[i * 4] = src[i * 3];
+    dst[i * 4 + 1] = src[i * 3 + 1];
+    dst[i * 4 + 2] = src[i * 3 + 2];
+    dst[i * 4 + 3] = 255;
+  }
+}
+
+} // namespace derp
@@ -0,0 +1,44 @@
+//===-- Implementation header for pixel conversion ------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // uint8_t, uint16_t
+
+namespace derp {
+
+// Converts an uncompressed image in place to the smallest format GL samples
+// without losing what the image holds:
+//
+//   8 bit, 1 or 2 channels  R8 / RG8. sRGB ones widen to SRGB8_ALPHA8, GL
+//                           has no single or dual channel sRGB format
+//   8 bit, 3 channels       padded to RGBA8 / SRGB8_ALPHA8, drivers store
+//                           RGB8 padded anyway and would pad on upload
+//   float, 1 or 2 channels  R16F / RG16F
+//   float, 3 channels       R11F_G11F_B10F, RGBA16F if anything is negative
+//   float, 4 channels       RGBA16F, R11F_G11F_B10F if alpha is always 1
+//
+// Call it after generate_mips() and compress(), compressed images are left
+// alone. Rows are spread over the pool's workers and the calling thread, the
+// overload without a pool converts on the caller.
+auto negotiate_format(image &img, thread_pool &pool) -> void;
+auto negotiate_format(image &img) -> void;
+
+// float to IEEE half with round to nearest even, clamped to the largest
+// finite half. F16C when the CPU has it.
+auto to_half(const float *src, uint16_t *dst, std::size_t count) -> void;
+
+// RGB to RGBA with opaque alpha, AVX2 when the CPU has it
+auto pad_rgb(const uint8_t *src, uint8_t *dst, std::size_t pixels) -> void;
+
+} // namespace derp
@@ -0,0 +1,141 @@
+//===-- Implementation of program cache class -----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "program_cache.hpp"
+
+#include "hash.hpp"
+
+#include <algorithm> // std::ranges::equal
+#include <format>    // std::format
+#include <fstream>   // std::ifstream, std::ofstream
+#include <print>     // std::println
+#include <vector>    // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+constexpr char MAGIC[4] = {'D', 'P', 'B', '1'};
+
+auto gl_string(const GLenum name) -> std::string_view {
+  const auto *s = reinterpret_cast<const char *>(glGetString(name));
+  return s ? s : "";
+}
+
+} // namespace
+
+program_cache::program_cache(std::filesystem::path dir)
+    : dir(std::move(dir)) {}
+
+auto program_cache::shared() -> program_cache & {
+  static program_cache cache;
+  return cache;
+}
+
+auto program_cache::path(const uint64_t key) const -> std::filesystem::path {
+  return dir / std::format("{:016x}.bin", key);
+}
+
+auto program_cache::key(const std::span<const shader_stage> stages,
+                        const std::string_view defines) -> uint64_t {
+  if (driver.empty()) {
+    int count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+    std::vector<int> formats(static_cast<std::size_t>(count));
+    if (count)
+      glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+
+    driver = std::format("{}|{}|{}", gl_string(GL_VENDOR),
+                         gl_string(GL_RENDERER), gl_string(GL_VERSION));
+    for (const int format : formats)
+      driver += std::format("|{:x}", format);
+  }
+
+  auto hash = fnv1a(driver);
+  hash = fnv1a(defines, fnv1a("|", hash));
+  for (const auto &[type, source] : stages)
+    hash = fnv1a(source, fnv1a(std::format("|{:x}|", type), hash));
+  return hash;
+}
+
+auto program_cache::load(const uint32_t program, const uint64_t key) -> bool {
+  const auto start = std::chrono::steady_clock::now();
+
+  std::ifstream file{path(key), std::ios::binary};
+  header h{};
+  if (!file || !file.read(reinterpret_cast<char *>(&h), sizeof(h)) ||
+      !std::ranges::equal(h.magic, MAGIC) || h.key != key) {
+    ++misses;
+    return false;
+  }
+
+  std::vector<char> blob(h.length);
+  if (!file.read(blob.data(), static_cast<std::streamsize>(blob.size()))) {
+    ++misses;
+    return false;
+  }
+
+  glProgramBinary(program, h.format, blob.data(),
+                  static_cast<GLsizei>(blob.size()));
+  int linked = 0;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    // the driver turned the blob down, rebuild and overwrite it
+    ++misses;
+    return false;
+  }
+
+  ++hits;
+  const auto took = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  saved += std::max(std::chrono::microseconds(h.compile_us) - took,
+                    std::chrono::microseconds(0));
+  return true;
+}
+
+auto program_cache::store(const uint32_t program, const uint64_t key,
+                          const std::chrono::microseconds compile_time)
+    -> void {
+  int length = 0;
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0)
+    return; // the driver keeps no binaries
+
+  std::vector<char> blob(static_cast<std::size_t>(length));
+  header h{};
+  std::ranges::copy(MAGIC, h.magic);
+  glGetProgramBinary(program, length, nullptr, &h.format, blob.data());
+  h.length = static_cast<uint32_t>(length);
+  h.compile_us = static_cast<uint32_t>(compile_time.count());
+  h.key = key;
+
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+
+  const auto target = path(key);
+  auto tmp = target;
+  tmp += ".tmp";
+  {
+    std::ofstream file{tmp, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    file.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+    if (!file)
+      return;
+  }
+  std::filesystem::rename(tmp, target, ec);
+}
+
+auto program_cache::report() const -> void {
+  std::println("[INFO] program cache: {} hits, {} misses, {:.1f} ms saved",
+               hits, misses, static_cast<double>(saved.count()) / 1000.0);
+}
+
+} // namespace derp
@@ -0,0 +1,81 @@
+//===-- Implementation header for program cache class ---------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>      // std::chrono::microseconds
+#include <cstdint>     // uint32_t, uint64_t
+#include <filesystem>  // std::filesystem::path
+#include <span>        // std::span
+#include <string>      // std::string
+#include <string_view> // std::string_view
+
+namespace derp {
+
+// one stage of a program, its GL type and the source as compiled
+struct shader_stage {
+  uint32_t type;
+  std::string_view source;
+};
+
+// On-disk cache of linked programs (glGetProgramBinary blobs), so later
+// launches skip compiling and linking.
+//
+// Entries are keyed by the stage sources, the defines, the driver's vendor,
+// renderer and version strings and the binary formats it supports: a driver
+// update simply misses. glProgramBinary may still reject a blob (drivers are
+// allowed to), load() then reports a miss and the caller builds from source.
+class program_cache {
+public:
+  static constexpr std::string_view DEFAULT_DIR = DERP_CACHE_PATH "/programs";
+
+private:
+  // file layout: header, then the blob
+  struct header {
+    char magic[4];
+    uint32_t format;     // GL binary format
+    uint32_t length;     // blob bytes
+    uint32_t compile_us; // what building from source took
+    uint64_t key;
+  };
+  static_assert(sizeof(header) == 24);
+
+  std::filesystem::path dir;
+  std::string driver; // vendor, renderer, version and formats, on first use
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  std::chrono::microseconds saved{0};
+
+  [[nodiscard]]
+  auto path(uint64_t key) const -> std::filesystem::path;
+
+public:
+  explicit program_cache(std::filesystem::path dir = DEFAULT_DIR);
+
+  // the cache shader uses
+  [[nodiscard]]
+  static auto shared() -> program_cache &;
+
+  [[nodiscard]]
+  auto key(std::span<const shader_stage> stages, std::string_view defines = {})
+      -> uint64_t;
+
+  // loads the entry into `program`, true if it linked
+  auto load(uint32_t program, uint64_t key) -> bool;
+
+  // stores a linked program built with GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+  // `compile_time` is what building it blocked the caller for
+  auto store(uint32_t program, uint64_t key,
+             std::chrono::microseconds compile_time) -> void;
+
+  // prints hits, misses and the time saved so far
+  auto report() const -> void;
+}; // class program_cache
+
+} // namespace derp
@@ -0,0 +1,142 @@
+//===-- Implementation of program reflection class ------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "program_reflection.hpp"
+
+#include <algorithm> // std::ranges::sort, std::ranges::lower_bound
+#include <array>     // std::array
+#include <format>    // std::format
+#include <stdexcept> // std::runtime_error
+#include <string>    // std::string
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+auto resource_name(const uint32_t program, const GLenum interface,
+                   const uint32_t index, std::string &name)
+    -> std::string_view {
+  int length = 0;
+  glGetProgramResourceName(program, interface, index,
+                           static_cast<int>(name.size()), &length,
+                           name.data());
+  std::string_view view(name.data(), static_cast<std::size_t>(length));
+  if (view.ends_with("[0]"))
+    view.remove_suffix(3);
+  return view;
+}
+
+template <typename T>
+auto sort_unique(std::vector<T> &entries, const uint32_t program,
+                 const std::string_view kind) -> void {
+  std::ranges::sort(entries, {}, &T::hash);
+  if (std::ranges::adjacent_find(entries, {}, &T::hash) != entries.end()) {
+    // two names sharing a 64 bit hash, rename one of them
+    throw std::runtime_error(std::format(
+        "[ERROR] {} name hash collision in program {}", kind, program));
+  }
+}
+
+auto read_blocks(const uint32_t program, const GLenum interface,
+                 std::string &name) -> std::vector<program_reflection::block> {
+  int count = 0;
+  glGetProgramInterfaceiv(program, interface, GL_ACTIVE_RESOURCES, &count);
+
+  constexpr std::array<GLenum, 2> props{GL_BUFFER_BINDING,
+                                        GL_BUFFER_DATA_SIZE};
+  std::vector<program_reflection::block> blocks;
+  blocks.reserve(static_cast<std::size_t>(count));
+  for (uint32_t i = 0; i < static_cast<uint32_t>(count); ++i) {
+    const auto block_name = resource_name(program, interface, i, name);
+    if (block_name.empty())
+      continue; // SPIR-V programs needn't keep names
+    std::array<int, props.size()> values{};
+    glGetProgramResourceiv(program, interface, i, props.size(), props.data(),
+                           values.size(), nullptr, values.data());
+    blocks.push_back({.hash = fnv1a(block_name),
+                      .index = i,
+                      .binding = values[0],
+                      .size = values[1]});
+  }
+  return blocks;
+}
+
+template <typename T>
+auto find(const std::vector<T> &entries, const uint64_t hash) noexcept
+    -> const T * {
+  const auto it = std::ranges::lower_bound(entries, hash, {}, &T::hash);
+  return it != entries.end() && it->hash == hash ? &*it : nullptr;
+}
+
+} // namespace
+
+program_reflection::program_reflection(const uint32_t program) {
+  // one name buffer, as long as the longest name of any interface
+  int longest = 0;
+  for (const GLenum interface :
+       {GL_UNIFORM, GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK}) {
+    int length = 0;
+    glGetProgramInterfaceiv(program, interface, GL_MAX_NAME_LENGTH, &length);
+    longest = std::max(longest, length);
+  }
+  std::string name(static_cast<std::size_t>(longest) + 1, '\0');
+
+  int count = 0;
+  glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+  constexpr std::array<GLenum, 4> props{GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE,
+                                        GL_BLOCK_INDEX};
+  uniforms.reserve(static_cast<std::size_t>(count));
+  for (uint32_t i = 0; i < static_cast<uint32_t>(count); ++i) {
+    std::array<int, props.size()> values{};
+    glGetProgramResourceiv(program, GL_UNIFORM, i, props.size(), props.data(),
+                           values.size(), nullptr, values.data());
+    if (values[3] != -1)
+      continue; // a block member, set through its buffer
+    const auto uniform_name = resource_name(program, GL_UNIFORM, i, name);
+    if (uniform_name.empty())
+      continue;
+    uniforms.push_back(
+        {.hash = fnv1a(uniform_name),
+         .location = values[0],
+         .type = static_cast<uint32_t>(values[1]),
+         .count = values[2]});
+  }
+
+  uniform_blocks = read_blocks(program, GL_UNIFORM_BLOCK, name);
+  storage_blocks = read_blocks(program, GL_SHADER_STORAGE_BLOCK, name);
+
+  sort_unique(uniforms, program, "uniform");
+  sort_unique(uniform_blocks, program, "uniform block");
+  sort_unique(storage_blocks, program, "storage block");
+}
+
+auto program_reflection::find_uniform(const uint64_t hash) const noexcept
+    -> const uniform * {
+  return find(uniforms, hash);
+}
+
+auto program_reflection::find_uniform_block(const uint64_t hash) const noexcept
+    -> const block * {
+  return find(uniform_blocks, hash);
+}
+
+auto program_reflection::find_storage_block(const uint64_t hash) const noexcept
+    -> const block * {
+  return find(storage_blocks, hash);
+}
+
+auto program_reflection::get_uniforms() const noexcept
+    -> std::span<const uniform> {
+  return uniforms;
+}
+
+} // namespace derp
@@ -0,0 +1,80 @@
+//===-- Implementation header for program reflection class ----------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "hash.hpp"
+
+#include <cstddef>     // std::size_t
+#include <cstdint>     // uint32_t, uint64_t
+#include <span>        // std::span
+#include <string_view> // std::string_view
+#include <vector>      // std::vector
+
+namespace derp {
+
+// A uniform or block name with its FNV-1a hash. String literals convert
+// implicitly and are hashed by the compiler, so s["u_model"] costs no hashing
+// at run time; names only known at run time have to say so.
+struct uniform_name {
+  uint64_t hash;
+  std::string_view name; // for error messages
+
+  template <std::size_t N>
+  consteval uniform_name(const char (&literal)[N])
+      : hash(fnv1a({literal, N - 1})), name(literal, N - 1) {}
+
+  constexpr explicit uniform_name(const std::string_view runtime)
+      : hash(fnv1a(runtime)), name(runtime) {}
+};
+
+// Everything a linked program exposes, read once with
+// glGetProgramInterfaceiv/glGetProgramResourceiv: default block uniforms,
+// uniform blocks and shader storage blocks. Each kind is a flat array sorted
+// by name hash, found with a binary search. Array uniforms are listed under
+// their plain name ("u_lights", not "u_lights[0]").
+class program_reflection {
+public:
+  struct uniform {
+    uint64_t hash;
+    int location;
+    uint32_t type; // GL_FLOAT_MAT4, GL_SAMPLER_2D, ...
+    int count;     // array size, 1 for plain uniforms
+  };
+
+  struct block {
+    uint64_t hash;
+    uint32_t index;
+    int binding;
+    int size; // bytes
+  };
+
+private:
+  std::vector<uniform> uniforms;
+  std::vector<block> uniform_blocks;
+  std::vector<block> storage_blocks;
+
+public:
+  program_reflection() = default;
+  explicit program_reflection(uint32_t program);
+
+  [[nodiscard]]
+  auto find_uniform(uint64_t hash) const noexcept -> const uniform *;
+
+  [[nodiscard]]
+  auto find_uniform_block(uint64_t hash) const noexcept -> const block *;
+
+  [[nodiscard]]
+  auto find_storage_block(uint64_t hash) const noexcept -> const block *;
+
+  [[nodiscard]]
+  auto get_uniforms() const noexcept -> std::span<const uniform>;
+}; // class program_reflection
+
+} // namespace derp
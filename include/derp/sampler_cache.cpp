@@ -0,0 +1,146 @@
+//===-- Implementation of sampler cache class -----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "sampler_cache.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm> // std::max, std::min
+#include <array>     // std::array
+#include <vector>    // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+// key layout, from the low bits up
+constexpr uint32_t FILTER_SHIFT = 0;  // 2 bits, sampler_desc::filter
+constexpr uint32_t WRAP_S_SHIFT = 2;  // 2 bits
+constexpr uint32_t WRAP_T_SHIFT = 4;  // 2 bits
+constexpr uint32_t BLEND_SHIFT = 6;   // 1 bit, blend between mips
+constexpr uint32_t ANISO_SHIFT = 7;   // 5 bits, 1 - 16
+constexpr uint32_t TWO_BITS = 3;
+
+constexpr std::array<int, 3> WRAP_MODES = {GL_REPEAT, GL_CLAMP_TO_EDGE,
+                                           GL_MIRRORED_REPEAT};
+
+auto anisotropy(const sampler_quality quality) -> float {
+  switch (quality) {
+  case sampler_quality::MEDIUM:
+    return 4.0f;
+  case sampler_quality::HIGH:
+    return 8.0f;
+  case sampler_quality::ULTRA:
+    return 16.0f;
+  default:
+    return 1.0f;
+  }
+}
+
+} // namespace
+
+sampler_cache::sampler_cache(const sampler_quality quality)
+    : quality(quality) {}
+
+sampler_cache::~sampler_cache() {
+  std::vector<uint32_t> ids;
+  ids.reserve(samplers.size());
+  for (const auto &[_, id] : samplers)
+    ids.push_back(id);
+  if (!ids.empty())
+    glDeleteSamplers(static_cast<GLsizei>(ids.size()), ids.data());
+}
+
+auto sampler_cache::shared() -> sampler_cache & {
+  static auto *cache = new sampler_cache();
+  return *cache;
+}
+
+auto sampler_cache::pack(const sampler_desc &desc) -> uint32_t {
+  using enum sampler_desc::filter;
+
+  if (max_anisotropy == 0.0f) {
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &max_anisotropy);
+    max_anisotropy = std::max(max_anisotropy, 1.0f);
+  }
+
+  const bool filtered = desc.filtering == TRILINEAR;
+  const bool blend = filtered && quality != sampler_quality::LOW;
+  const float aniso =
+      filtered && desc.anisotropic
+          ? std::min(anisotropy(quality), max_anisotropy)
+          : 1.0f;
+
+  return static_cast<uint32_t>(desc.filtering) << FILTER_SHIFT |
+         static_cast<uint32_t>(desc.wrap_s) << WRAP_S_SHIFT |
+         static_cast<uint32_t>(desc.wrap_t) << WRAP_T_SHIFT |
+         static_cast<uint32_t>(blend) << BLEND_SHIFT |
+         static_cast<uint32_t>(aniso) << ANISO_SHIFT;
+}
+
+auto sampler_cache::create(const uint32_t key) -> uint32_t {
+  using enum sampler_desc::filter;
+  const auto filtering =
+      static_cast<sampler_desc::filter>(key >> FILTER_SHIFT & TWO_BITS);
+  const bool blend = key >> BLEND_SHIFT & 1;
+
+  int min_filter = GL_NEAREST_MIPMAP_NEAREST;
+  int mag_filter = GL_NEAREST;
+  if (filtering == BILINEAR) {
+    min_filter = GL_LINEAR;
+    mag_filter = GL_LINEAR;
+  } else if (filtering == TRILINEAR) {
+    min_filter = blend ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+    mag_filter = GL_LINEAR;
+  }
+
+  uint32_t id = 0;
+  glCreateSamplers(1, &id);
+  glSamplerParameteri(id, GL_TEXTURE_MIN_FILTER, min_filter);
+  glSamplerParameteri(id, GL_TEXTURE_MAG_FILTER, mag_filter);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_S,
+                      WRAP_MODES[key >> WRAP_S_SHIFT & TWO_BITS]);
+  glSamplerParameteri(id, GL_TEXTURE_WRAP_T,
+                      WRAP_MODES[key >> WRAP_T_SHIFT & TWO_BITS]);
+  glSamplerParameterf(id, GL_TEXTURE_MAX_ANISOTROPY,
+                      static_cast<float>(key >> ANISO_SHIFT));
+  return id;
+}
+
+auto sampler_cache::get(const sampler_desc &desc) -> uint32_t {
+  const auto key = pack(desc);
+  auto [it, inserted] = samplers.try_emplace(key, 0);
+  if (inserted)
+    it->second = create(key);
+  return it->second;
+}
+
+auto sampler_cache::bind(const uint32_t first,
+                         const std::span<const sampler_desc> descs) -> void {
+  std::vector<uint32_t> ids;
+  ids.reserve(descs.size());
+  for (const auto &desc : descs)
+    ids.push_back(get(desc));
+  gl_state::shared().bind_samplers(first, ids);
+}
+
+auto sampler_cache::set_quality(const sampler_quality q) noexcept -> void {
+  quality = q;
+}
+
+auto sampler_cache::get_quality() const noexcept -> sampler_quality {
+  return quality;
+}
+
+auto sampler_cache::size() const noexcept -> std::size_t {
+  return samplers.size();
+}
+
+} // namespace derp
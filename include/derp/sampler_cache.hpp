@@ -0,0 +1,96 @@
+//===-- Implementation header for sampler cache class ---------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // uint8_t, uint32_t
+#include <span>          // std::span
+#include <unordered_map> // std::unordered_map
+
+// set DERP_SAMPLER_QUALITY in CMake to pick the deployment's default
+#ifndef DERP_SAMPLER_QUALITY
+#define DERP_SAMPLER_QUALITY HIGH
+#endif
+
+namespace derp {
+
+// How a texture wants to be sampled. The anisotropy, and whether mips are
+// blended, come from the cache's quality instead.
+struct sampler_desc {
+  // NEAREST picks the nearest texel of the nearest mip, BILINEAR filters
+  // level 0 only, TRILINEAR filters and blends between mips
+  enum class filter : uint8_t { NEAREST, BILINEAR, TRILINEAR };
+  enum class wrap : uint8_t { REPEAT, CLAMP, MIRROR };
+
+  filter filtering = filter::TRILINEAR;
+  wrap wrap_s = wrap::CLAMP;
+  wrap wrap_t = wrap::CLAMP;
+  bool anisotropic = true; // off for atlases and page caches
+
+  auto operator==(const sampler_desc &) const -> bool = default;
+};
+
+// LOW samples the nearest mip only and skips anisotropy, the others blend
+// mips with 4x, 8x and 16x anisotropy (clamped to what the GPU supports).
+enum class sampler_quality : uint8_t { LOW, MEDIUM, HIGH, ULTRA };
+
+// Sampler objects shared by every texture with the same state, so textures
+// carry no filtering state of their own. Samplers are keyed by their
+// resolved state packed into 32 bits: descriptors that end up the same under
+// the current quality share one object.
+//
+// Samplers never change once created, ARB_bindless_texture freezes the ones
+// a handle was made with. set_quality() only affects what get() resolves to
+// from then on; bound units pick it up on their next bind, existing bindless
+// handles keep the old state.
+class sampler_cache {
+public:
+  static constexpr sampler_quality DEFAULT_QUALITY =
+      sampler_quality::DERP_SAMPLER_QUALITY;
+
+private:
+  std::unordered_map<uint32_t, uint32_t> samplers; // packed state to sampler
+  sampler_quality quality;
+  float max_anisotropy = 0.0f; // queried on first use
+
+  [[nodiscard]]
+  auto pack(const sampler_desc &desc) -> uint32_t;
+
+  static auto create(uint32_t key) -> uint32_t;
+
+public:
+  explicit sampler_cache(sampler_quality quality = DEFAULT_QUALITY);
+  ~sampler_cache();
+
+  sampler_cache(const sampler_cache &) = delete;
+  sampler_cache &operator=(const sampler_cache &) = delete;
+
+  // the cache textures bind through, never freed, like the placeholders
+  [[nodiscard]]
+  static auto shared() -> sampler_cache &;
+
+  // sampler object for `desc` under the current quality
+  [[nodiscard]]
+  auto get(const sampler_desc &desc) -> uint32_t;
+
+  // binds descs[i] to unit first + i in one call
+  auto bind(uint32_t first, std::span<const sampler_desc> descs) -> void;
+
+  auto set_quality(sampler_quality q) noexcept -> void;
+
+  [[nodiscard]]
+  auto get_quality() const noexcept -> sampler_quality;
+
+  // distinct sampler objects created so far
+  [[nodiscard]]
+  auto size() const noexcept -> std::size_t;
+}; // class sampler_cache
+
+} // namespace derp
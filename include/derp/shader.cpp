@@ -8,104 +8,36 @@
 //===----------------------------------------------------------------------===//
 
 #include "shader.hpp"
+#include "gl_state.hpp"
+#include "pipeline_cache.hpp"
+#include "shader_compiler.hpp"
 
-#include <cassert> // assert
-#include <fstream>
+#include <cassert>   // assert
+#include <memory>    // std::make_unique
 #include <print>     // std::print
 #include <stdexcept> // std::runtime_error
+#include <utility>   // std::exchange, std::move
 
 namespace derp {
 
 shader::shader(const std::string &vert_path, const std::string &frag_path)
-    : deleted(false) {
-  id = 0;
+    : shader([&] {
+        shader_compiler compiler;
+        auto built = compiler.submit(vert_path, frag_path);
+        compiler.wait();
+        return built.get();
+      }()) {}
 
-  auto read_file = [](const std::string &path) -> std::string {
-    if (std::ifstream file{path, std::ios::binary | std::ios::ate}) {
-      const auto size = file.tellg();
-      std::string content;
-      content.resize(size);
-      file.seekg(0);
-      if (!file.read(content.data(), size)) {
-        throw std::runtime_error(
-            std::format("[ERROR] Failed to read file: {}.", path));
-      }
-      return content; // NRVO
-    }
-    throw std::runtime_error(
-        std::format("[ERROR] Couldn't open file: {}.", path));
-  };
-
-  const auto vert_str = read_file(vert_path);
-  const auto frag_str = read_file(frag_path);
-
-  const char *vert_src = vert_str.c_str();
-  const char *frag_src = frag_str.c_str();
-
-  // std::println("[DEBUG] Vertex Shader Source:\n{}", vert_src);
-  // std::println("[DEBUG] Fragment Shader Source:\n{}", frag_src);
-
-  const uint32_t vs = glCreateShader(GL_VERTEX_SHADER);
-  const uint32_t fs = glCreateShader(GL_FRAGMENT_SHADER);
-
-  glShaderSource(vs, 1, &vert_src, nullptr);
-  glCompileShader(vs);
-
-  int result;
-  char info_log[1024];
-  glGetShaderiv(vs, GL_COMPILE_STATUS, &result);
-  if (!result) {
-    glGetShaderInfoLog(vs, 1024, nullptr, info_log);
-    throw std::runtime_error(
-        std::format("[ERROR] Vertex Shader Compilation Failed.\n{}", info_log));
-  }
-
-  glShaderSource(fs, 1, &frag_src, nullptr);
-  glCompileShader(fs);
-
-  glGetShaderiv(fs, GL_COMPILE_STATUS, &result);
-  if (!result) {
-    glGetShaderInfoLog(fs, 1024, nullptr, info_log);
-    throw std::runtime_error(std::format(
-        "[ERROR] Fragment Shader Compilation Failed.\n{}", info_log));
-  }
-
-  id = glCreateProgram();
-
-  glAttachShader(id, vs);
-  glAttachShader(id, fs);
-
-  glLinkProgram(id);
-  glGetProgramiv(id, GL_LINK_STATUS, &result);
-  if (!result) {
-    glGetProgramInfoLog(id, 1024, nullptr, info_log);
-    throw std::runtime_error(
-        std::format("[ERROR] Program Link Failed.\n{}", info_log));
-  }
-
-  glValidateProgram(id);
-
-  glGetProgramiv(id, GL_VALIDATE_STATUS, &result);
-  if (!result) {
-    glGetProgramInfoLog(id, 1024, nullptr, info_log);
-    throw std::runtime_error(
-        std::format("[ERROR] Program Validation Failed.\n{}", info_log));
-  }
-
-  glDetachShader(id, vs);
-  glDetachShader(id, fs);
-
-  glDeleteShader(vs);
-  glDeleteShader(fs);
-
-  // std::println("[DEBUG] Program with id = {} successfully created.", id);
-}
+shader::shader(const uint32_t program)
+    : id(program), deleted(false), reflection(program),
+      uniforms(std::make_unique<uniform_shadow>(program, reflection)) {}
 
 shader::~shader() {
   // std::println("[DEBUG] attempting to delete program with id = {}", id);
   if (deleted)
     return;
-  glUseProgram(0);
+  gl_state::shared().forget_program(id);
+  pipeline_cache::shared().forget(id);
   if (glIsProgram(id))
     glDeleteProgram(id);
   deleted = true;
@@ -115,16 +47,20 @@ shader::~shader() {
 shader::shader(shader &&other) noexcept
     : id(std::exchange(other.id, 0)),
       deleted(std::exchange(other.deleted, true)),
-      uniform_map(std::move(other.uniform_map)) {}
+      reflection(std::move(other.reflection)),
+      uniforms(std::move(other.uniforms)) {}
 
 auto shader::operator=(shader &&other) noexcept -> shader & {
   if (this != &other) {
     if (!deleted && glIsProgram(id)) {
+      gl_state::shared().forget_program(id);
+      pipeline_cache::shared().forget(id);
       glDeleteProgram(id);
     }
     id = std::exchange(other.id, 0);
     deleted = std::exchange(other.deleted, true);
-    uniform_map = std::move(other.uniform_map); // Move the map contents
+    reflection = std::move(other.reflection);
+    uniforms = std::move(other.uniforms);
   }
   return *this;
 }
@@ -134,37 +70,33 @@ auto shader::use() const -> void {
     throw std::runtime_error(std::format(
         "[ERROR ] attempted to use deleted shader program with id = {}.", id));
   }
-  glUseProgram(id);
+  auto &state = gl_state::shared();
+  state.verify();
+  state.use_program(id);
   // std::println("[DEBUG] program with id = {} used.", id);
 }
 
-[[nodiscard]] auto shader::get_uniform_location(std::string_view name) const
-    -> int {
+auto shader::find_uniform(const uniform_name &name) const
+    -> const program_reflection::uniform & {
   if (deleted) {
     throw std::runtime_error(std::format(
         "Attempted to get uniform location '{}' on deleted shader program",
-        name));
+        name.name));
   }
-
-  if (const auto it = uniform_map.find(name); it != uniform_map.end()) {
-    return it->second;
-  }
-
-  if (!glIsProgram(id)) {
-    throw std::runtime_error(
-        std::format("Attempted to get uniform location '{}' on invalid shader "
-                    "program (id was {})",
-                    name, id));
-  }
-  const int location = glGetUniformLocation(id, name.data());
-
-  if (location == -1) {
+  const auto *u = reflection.find_uniform(name.hash);
+  if (!u) {
     throw std::runtime_error(std::format(
-        "[ERROR] uniform '{}' not found in shader program {}", name, id));
+        "[ERROR] uniform '{}' not found in shader program {}", name.name, id));
   }
+  return *u;
+}
+
+auto shader::get_reflection() const noexcept -> const program_reflection & {
+  return reflection;
+}
 
-  uniform_map.emplace(std::string(name), location);
-  return location;
+auto shader::get_id() const noexcept -> uint32_t {
+  return id;
 }
 
 } // namespace derp
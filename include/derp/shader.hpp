@@ -9,15 +9,18 @@
 
 #pragma once
 
-#include <concepts>      // std::same_as, std::convertible_to
-#include <cstdint>       // uint32_t
-#include <format>        // std::format
-#include <functional>    // std::hash, std::equal_to
-#include <string>        // std::string
-#include <string_view>   // std::string_view
-#include <type_traits>   // std::decay_t
-#include <unordered_map> // std::unordered_map
-#include <utility>       // std::forward, std::move, std::exchange
+#include "program_reflection.hpp"
+#include "uniform_shadow.hpp"
+
+#include <cassert>     // assert
+#include <concepts>    // std::same_as
+#include <cstdint>     // uint32_t
+#include <cstddef>     // std::size_t
+#include <format>      // std::format
+#include <memory>      // std::unique_ptr
+#include <stdexcept>   // std::runtime_error
+#include <string>      // std::string
+#include <type_traits> // std::decay_t
 
 #include <glad/glad.h>
 
@@ -38,35 +41,158 @@ concept UniformType = requires {
                std::same_as<std::decay_t<T>, glm::mat4>;
 };
 
-struct StringViewHash {
-  using is_transparent = void;
-  [[nodiscard]] std::size_t
-  operator()(const std::string_view sv) const noexcept {
-    return std::hash<std::string_view>{}(sv);
+// true for samplers and images, which are set with an int unit
+constexpr auto uniform_is_opaque(const uint32_t type) noexcept -> bool {
+  switch (type) {
+  case GL_FLOAT:
+  case GL_FLOAT_VEC2:
+  case GL_FLOAT_VEC3:
+  case GL_FLOAT_VEC4:
+  case GL_FLOAT_MAT2:
+  case GL_FLOAT_MAT3:
+  case GL_FLOAT_MAT4:
+  case GL_FLOAT_MAT2x3:
+  case GL_FLOAT_MAT2x4:
+  case GL_FLOAT_MAT3x2:
+  case GL_FLOAT_MAT3x4:
+  case GL_FLOAT_MAT4x2:
+  case GL_FLOAT_MAT4x3:
+  case GL_DOUBLE:
+  case GL_DOUBLE_VEC2:
+  case GL_DOUBLE_VEC3:
+  case GL_DOUBLE_VEC4:
+  case GL_DOUBLE_MAT2:
+  case GL_DOUBLE_MAT3:
+  case GL_DOUBLE_MAT4:
+  case GL_DOUBLE_MAT2x3:
+  case GL_DOUBLE_MAT2x4:
+  case GL_DOUBLE_MAT3x2:
+  case GL_DOUBLE_MAT3x4:
+  case GL_DOUBLE_MAT4x2:
+  case GL_DOUBLE_MAT4x3:
+  case GL_INT:
+  case GL_INT_VEC2:
+  case GL_INT_VEC3:
+  case GL_INT_VEC4:
+  case GL_UNSIGNED_INT:
+  case GL_UNSIGNED_INT_VEC2:
+  case GL_UNSIGNED_INT_VEC3:
+  case GL_UNSIGNED_INT_VEC4:
+  case GL_BOOL:
+  case GL_BOOL_VEC2:
+  case GL_BOOL_VEC3:
+  case GL_BOOL_VEC4:
+    return false;
+  default:
+    return true;
   }
-  [[nodiscard]] std::size_t operator()(const std::string &s) const noexcept {
-    return std::hash<std::string>{}(s);
+}
+
+// true if a uniform of GL type `type` takes values of T. ints also set
+// samplers and images
+template <UniformType T>
+constexpr auto uniform_accepts(const uint32_t type) noexcept -> bool {
+  using DecayedT = std::decay_t<T>;
+  if constexpr (std::same_as<DecayedT, float>) {
+    return type == GL_FLOAT;
+  } else if constexpr (std::same_as<DecayedT, glm::vec2>) {
+    return type == GL_FLOAT_VEC2;
+  } else if constexpr (std::same_as<DecayedT, glm::vec3>) {
+    return type == GL_FLOAT_VEC3;
+  } else if constexpr (std::same_as<DecayedT, glm::vec4>) {
+    return type == GL_FLOAT_VEC4;
+  } else if constexpr (std::same_as<DecayedT, glm::mat3>) {
+    return type == GL_FLOAT_MAT3;
+  } else if constexpr (std::same_as<DecayedT, glm::mat4>) {
+    return type == GL_FLOAT_MAT4;
+  } else {
+    return type == GL_INT || type == GL_BOOL || uniform_is_opaque(type);
   }
-  [[nodiscard]] std::size_t operator()(const char *cstr) const noexcept {
-    return std::hash<std::string_view>{}(cstr);
+}
+
+// writes `value` to `location` of `program`, bound or not, right away
+template <UniformType T>
+auto set_uniform(const uint32_t program, const int location, const T &value)
+    -> void {
+  using DecayedT = std::decay_t<T>;
+
+  if constexpr (std::same_as<DecayedT, float>) {
+    glProgramUniform1f(program, location, value);
+  } else if constexpr (std::same_as<DecayedT, int>) {
+    glProgramUniform1i(program, location, value);
+  } else if constexpr (std::same_as<DecayedT, bool>) {
+    glProgramUniform1i(program, location, static_cast<int>(value));
+  } else if constexpr (std::same_as<DecayedT, glm::vec2>) {
+    glProgramUniform2fv(program, location, 1, glm::value_ptr(value));
+  } else if constexpr (std::same_as<DecayedT, glm::vec3>) {
+    glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
+  } else if constexpr (std::same_as<DecayedT, glm::vec4>) {
+    glProgramUniform4fv(program, location, 1, glm::value_ptr(value));
+  } else if constexpr (std::same_as<DecayedT, glm::mat3>) {
+    glProgramUniformMatrix3fv(program, location, 1, GL_FALSE,
+                              glm::value_ptr(value));
+  } else if constexpr (std::same_as<DecayedT, glm::mat4>) {
+    glProgramUniformMatrix4fv(program, location, 1, GL_FALSE,
+                              glm::value_ptr(value));
   }
-};
+  // TODO: Add glGetError check here?
+}
+
+// A uniform looked up once, kept for the frame loop. Setting it goes to the
+// shader's uniform_shadow, the type was checked when the handle was made.
+// Valid as long as the shader is.
+template <UniformType T> class uniform_handle {
+private:
+  friend class shader;
+
+  uniform_shadow *shadow = nullptr;
+  std::size_t index = 0; // in the reflection table
+  int location = -1;
+
+  uniform_handle(uniform_shadow *shadow, const std::size_t index,
+                 const int loc)
+      : shadow(shadow), index(index), location(loc) {}
+
+public:
+  uniform_handle() = default;
+
+  auto operator=(const T &value) const -> const uniform_handle & {
+    shadow->write(index, value);
+    return *this;
+  }
+
+  [[nodiscard]]
+  explicit operator bool() const noexcept {
+    return location != -1;
+  }
+}; // class uniform_handle
 
 class shader {
 private:
   uint32_t id = 0;
   bool deleted = true;
+  program_reflection reflection; // read at link time
+  // uniform writes until the next draw, on the heap so handles survive moves
+  std::unique_ptr<uniform_shadow> uniforms;
 
-  using UniformMap =
-      std::unordered_map<std::string, int, StringViewHash,
-                         std::equal_to<> // for transparent lookup
-                         >;
-  mutable UniformMap uniform_map;
+  // the table entry of `name`, throws if the program has no such uniform
+  [[nodiscard]]
+  auto find_uniform(const uniform_name &name) const
+      -> const program_reflection::uniform &;
 
-  [[nodiscard]] int get_uniform_location(std::string_view name) const;
+  [[nodiscard]]
+  auto uniform_index(const program_reflection::uniform &u) const noexcept
+      -> std::size_t {
+    return static_cast<std::size_t>(&u - reflection.get_uniforms().data());
+  }
+
+  // takes over a linked program
+  friend class shader_compiler;
+  explicit shader(uint32_t program);
 
 public:
   shader() = delete;
+  // builds on the spot, shader_compiler builds without stalling
   shader(const std::string &vert_path, const std::string &frag_path);
   // shader(const std::string &vert_path, const std::string &frag_path,
   // const std::string &geom_path);
@@ -83,11 +209,14 @@ public:
   private:
     friend class shader;
 
-    uint32_t program_id;
+    uniform_shadow *shadow;
+    std::size_t index;
     int location;
+    uint32_t type;
 
-    UniformProxy(const uint32_t prog_id, const int loc)
-        : program_id(prog_id), location(loc) {
+    UniformProxy(uniform_shadow *shadow, const std::size_t index,
+                 const int loc, const uint32_t ty)
+        : shadow(shadow), index(index), location(loc), type(ty) {
     } // Don't allow default construction or copying
 
   public:
@@ -103,51 +232,52 @@ public:
 
   }; // UniformProxy
 
-  template <typename T>
-    requires std::convertible_to<T, std::string_view>
+  // string literals are hashed at compile time, a lookup is a binary search
+  // of the reflection table. values reach GL at the next draw, and only if
+  // they changed
   [[nodiscard]]
-  auto operator[](T &&name) const -> UniformProxy {
-    const int location =
-        get_uniform_location(std::string_view(std::forward<T>(name)));
-    return {id, location};
+  auto operator[](const uniform_name &name) const -> UniformProxy {
+    const auto &u = find_uniform(name);
+    return {uniforms.get(), uniform_index(u), u.location, u.type};
   }
+
+  // a typed handle to keep across frames, throws if T doesn't fit
+  template <UniformType T>
+  [[nodiscard]]
+  auto handle(const uniform_name &name) const -> uniform_handle<T>;
+
+  [[nodiscard]]
+  auto get_reflection() const noexcept -> const program_reflection &;
+
+  // the GL program, for pipeline_cache
+  [[nodiscard]]
+  auto get_id() const noexcept -> uint32_t;
 }; // class shader
 
 template <UniformType T>
 auto shader::UniformProxy::operator=(const T &value) const
     -> const UniformProxy & {
-  int current_program = 0;
-  glGetIntegerv(GL_CURRENT_PROGRAM, &current_program);
-  if (static_cast<uint32_t>(current_program) != program_id) {
+  assert(location != -1);
+  if (!uniform_accepts<T>(type)) {
     throw std::runtime_error(
-        std::format("Attempted to set uniform for shader program {} "
-                    "when program {} is active.",
-                    program_id, current_program));
+        std::format("[ERROR] uniform at location {} has GL type {:#x}, not "
+                    "the value's",
+                    location, type));
   }
+  shadow->write(index, value);
+  return *this;
+}
 
-  assert(location != -1);
-
-  using DecayedT = std::decay_t<T>;
-
-  if constexpr (std::same_as<DecayedT, float>) {
-    glUniform1f(location, value);
-  } else if constexpr (std::same_as<DecayedT, int>) {
-    glUniform1i(location, value);
-  } else if constexpr (std::same_as<DecayedT, bool>) {
-    glUniform1i(location, static_cast<int>(value));
-  } else if constexpr (std::same_as<DecayedT, glm::vec2>) {
-    glUniform2fv(location, 1, glm::value_ptr(value));
-  } else if constexpr (std::same_as<DecayedT, glm::vec3>) {
-    glUniform3fv(location, 1, glm::value_ptr(value));
-  } else if constexpr (std::same_as<DecayedT, glm::vec4>) {
-    glUniform4fv(location, 1, glm::value_ptr(value));
-  } else if constexpr (std::same_as<DecayedT, glm::mat3>) {
-    glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(value));
-  } else if constexpr (std::same_as<DecayedT, glm::mat4>) {
-    glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+template <UniformType T>
+auto shader::handle(const uniform_name &name) const -> uniform_handle<T> {
+  const auto &u = find_uniform(name);
+  if (!uniform_accepts<T>(u.type)) {
+    throw std::runtime_error(
+        std::format("[ERROR] uniform '{}' of shader program {} has GL type "
+                    "{:#x}, not the handle's",
+                    name.name, id, u.type));
   }
-  // TODO: Add glGetError check here?
-  return *this;
+  return {uniforms.get(), uniform_index(u), u.location};
 }
 
 } // namespace derp
@@ -0,0 +1,379 @@
+//===-- Implementation of shader compiler class ---------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shader_compiler.hpp"
+
+#include <algorithm> // std::max, std::ranges::find
+#include <array>     // std::array
+#include <exception> // std::make_exception_ptr
+#include <format>    // std::format
+#include <fstream>   // std::ifstream
+#include <stdexcept> // std::runtime_error
+#include <utility>   // std::move
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+auto stage_name(const uint32_t shader) -> std::string_view {
+  int type = 0;
+  glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+  switch (type) {
+  case GL_VERTEX_SHADER:
+    return "Vertex";
+  case GL_FRAGMENT_SHADER:
+    return "Fragment";
+  case GL_GEOMETRY_SHADER:
+    return "Geometry";
+  case GL_COMPUTE_SHADER:
+    return "Compute";
+  default:
+    return "Unknown";
+  }
+}
+
+auto shader_log(const uint32_t shader) -> std::string {
+  int length = 0;
+  glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+  std::string log(static_cast<std::size_t>(std::max(length, 1)), '\0');
+  glGetShaderInfoLog(shader, length, nullptr, log.data());
+  log.resize(log.find('\0'));
+  return log;
+}
+
+auto program_log(const uint32_t program) -> std::string {
+  int length = 0;
+  glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+  std::string log(static_cast<std::size_t>(std::max(length, 1)), '\0');
+  glGetProgramInfoLog(program, length, nullptr, log.data());
+  log.resize(log.find('\0'));
+  return log;
+}
+
+auto read_binary(const std::filesystem::path &path) -> std::string {
+  std::ifstream file{path, std::ios::binary | std::ios::ate};
+  if (!file)
+    throw std::runtime_error(
+        std::format("[ERROR] Couldn't open file: {}.", path.string()));
+  std::string content(static_cast<std::size_t>(file.tellg()), '\0');
+  file.seekg(0);
+  file.read(content.data(), static_cast<std::streamsize>(content.size()));
+  return content;
+}
+
+// no status checks, they would wait for the compile
+auto link(const uint32_t program) -> void {
+  glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  glLinkProgram(program);
+}
+
+auto elapsed(const std::chrono::steady_clock::time_point since)
+    -> std::chrono::microseconds {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - since);
+}
+
+} // namespace
+
+shader_compiler::shader_compiler()
+    : parallel(supported()), spirv(spirv_supported()) {
+  if (parallel)
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // as many as the driver likes
+}
+
+shader_compiler::~shader_compiler() {
+  for (const auto &j : jobs) {
+    for (const auto s : j.shaders)
+      glDeleteShader(s);
+    glDeleteProgram(j.program);
+  }
+}
+
+auto shader_compiler::supported() -> bool {
+  return GLAD_GL_KHR_parallel_shader_compile;
+}
+
+auto shader_compiler::spirv_supported() -> bool {
+#ifdef DERP_SPIRV_PATH
+  return GLAD_GL_VERSION_4_6;
+#else
+  return false;
+#endif
+}
+
+auto shader_compiler::get_preprocessor() noexcept -> glsl_preprocessor & {
+  return preprocessor;
+}
+
+auto shader_compiler::take_files() -> std::vector<std::filesystem::path> {
+  return std::exchange(files_read, {});
+}
+
+auto shader_compiler::mark_stale(const std::filesystem::path &path) -> void {
+  auto normal = std::filesystem::absolute(path).lexically_normal();
+  if (std::ranges::find(stale, normal) == stale.end())
+    stale.push_back(std::move(normal));
+}
+
+auto shader_compiler::submit(const std::span<const shader_stage> stages,
+                             std::string name, ready_callback ready)
+    -> void {
+  start(stages, std::move(name), false, std::move(ready));
+}
+
+auto shader_compiler::begin(const uint64_t key, std::string name,
+                            const bool separable, ready_callback ready)
+    -> job {
+  job j{.name = std::move(name),
+        .program = glCreateProgram(),
+        .shaders = {},
+        .key = key,
+        .separable = separable,
+        .spent = {},
+        .ready = std::move(ready)};
+  if (separable)
+    glProgramParameteri(j.program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+  return j;
+}
+
+auto shader_compiler::start(const std::span<const shader_stage> stages,
+                            std::string name, const bool separable,
+                            ready_callback ready) -> void {
+  auto &cache = program_cache::shared();
+  auto j = begin(cache.key(stages, separable ? "separable" : ""),
+                 std::move(name), separable, std::move(ready));
+  if (!cache.load(j.program, j.key)) {
+    const auto started = std::chrono::steady_clock::now();
+    for (const auto &[type, source] : stages) {
+      const uint32_t s = glCreateShader(type);
+      const char *src = source.data();
+      const auto length = static_cast<int>(source.size());
+      glShaderSource(s, 1, &src, &length);
+      glCompileShader(s);
+      glAttachShader(j.program, s);
+      j.shaders.push_back(s);
+    }
+    link(j.program);
+    j.spent += elapsed(started);
+  }
+  jobs.push_back(std::move(j));
+}
+
+auto shader_compiler::submit(const std::string &vert_path,
+                             const std::string &frag_path,
+                             const std::span<const std::string> defines,
+                             ready_callback ready) -> void {
+  const auto vert = preprocessor.process(vert_path, defines);
+  if (!vert)
+    throw std::runtime_error(vert.error());
+  const auto frag = preprocessor.process(frag_path, defines);
+  if (!frag)
+    throw std::runtime_error(frag.error());
+  files_read.insert(files_read.end(), vert->files.begin(),
+                    vert->files.end());
+  files_read.insert(files_read.end(), frag->files.begin(),
+                    frag->files.end());
+
+  const std::array<shader_stage, 2> stages{
+      {{GL_VERTEX_SHADER, vert->source}, {GL_FRAGMENT_SHADER, frag->source}}};
+  submit(stages, std::format("{} + {}", vert_path, frag_path),
+         std::move(ready));
+}
+
+auto shader_compiler::submit(const std::string &vert_path,
+                             const std::string &frag_path,
+                             ready_callback ready) -> void {
+  submit(vert_path, frag_path, {}, std::move(ready));
+}
+
+auto shader_compiler::submit_compute(const std::string &path,
+                                     const std::span<const std::string> defines,
+                                     ready_callback ready) -> void {
+  const auto comp = preprocessor.process(path, defines);
+  if (!comp)
+    throw std::runtime_error(comp.error());
+  files_read.insert(files_read.end(), comp->files.begin(),
+                    comp->files.end());
+  const shader_stage stages[] = {{GL_COMPUTE_SHADER, comp->source}};
+  submit(stages, path, std::move(ready));
+}
+
+auto shader_compiler::spirv_module(const std::string &path) const
+    -> std::optional<std::filesystem::path> {
+#ifdef DERP_SPIRV_PATH
+  const auto normal = std::filesystem::absolute(path).lexically_normal();
+  if (spirv && std::ranges::find(stale, normal) == stale.end()) {
+    // named after the source, material.frag is material.frag.spv
+    auto module = std::filesystem::path(DERP_SPIRV_PATH) /
+                  (std::filesystem::path(path).filename().string() + ".spv");
+    std::error_code ec;
+    if (std::filesystem::is_regular_file(module, ec))
+      return module;
+  }
+#endif
+  return std::nullopt;
+}
+
+auto shader_compiler::submit_stage(
+    const uint32_t type, const std::string &path,
+    const std::span<const std::string> defines,
+    const std::span<const spec_constant> constants, ready_callback ready,
+    const bool from_source) -> void {
+  // preprocessed either way, for the files it reads
+  const auto stage = preprocessor.process(path, defines);
+  if (!stage)
+    throw std::runtime_error(stage.error());
+  files_read.insert(files_read.end(), stage->files.begin(),
+                    stage->files.end());
+
+  const auto module = from_source ? std::nullopt : spirv_module(path);
+  if (!module) {
+    const shader_stage stages[] = {{type, stage->source}};
+    start(stages, path, true, std::move(ready));
+    return;
+  }
+
+  const auto binary = read_binary(*module);
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t> values;
+  std::string constants_key = "separable spirv";
+  for (const auto &[id, value] : constants) {
+    ids.push_back(id);
+    values.push_back(value);
+    constants_key += std::format(" {}={}", id, value);
+  }
+
+  auto &cache = program_cache::shared();
+  const shader_stage stages[] = {{type, binary}};
+  auto j = begin(cache.key(stages, constants_key), path, true,
+                 std::move(ready));
+  if (!cache.load(j.program, j.key)) {
+    const auto started = std::chrono::steady_clock::now();
+    const uint32_t s = glCreateShader(type);
+    glShaderBinary(1, &s, GL_SHADER_BINARY_FORMAT_SPIR_V, binary.data(),
+                   static_cast<int>(binary.size()));
+    glSpecializeShader(s, "main", static_cast<uint32_t>(ids.size()),
+                       ids.data(), values.data());
+    glAttachShader(j.program, s);
+    j.shaders.push_back(s);
+    link(j.program);
+    j.spent += elapsed(started);
+  }
+  jobs.push_back(std::move(j));
+}
+
+auto shader_compiler::submit(const std::string &vert_path,
+                             const std::string &frag_path)
+    -> std::future<shader> {
+  std::promise<shader> promise;
+  auto future = promise.get_future();
+  submit(vert_path, frag_path,
+         [promise = std::move(promise)](result built) mutable {
+           if (built)
+             promise.set_value(std::move(*built));
+           else
+             promise.set_exception(
+                 std::make_exception_ptr(std::runtime_error(built.error())));
+         });
+  return future;
+}
+
+auto shader_compiler::done(const job &j) const -> bool {
+  if (j.shaders.empty() || !parallel)
+    return true;
+  int complete = 0;
+  glGetProgramiv(j.program, GL_COMPLETION_STATUS_KHR, &complete);
+  return complete;
+}
+
+auto shader_compiler::finish(job &j) -> result {
+  if (j.shaders.empty())
+    return shader(j.program);
+
+  // without the extension the status query blocks until the driver is done
+  const auto started = std::chrono::steady_clock::now();
+  int linked = 0;
+  glGetProgramiv(j.program, GL_LINK_STATUS, &linked);
+
+  std::string error;
+  if (!linked) {
+    for (const auto s : j.shaders) {
+      int compiled = 0;
+      glGetShaderiv(s, GL_COMPILE_STATUS, &compiled);
+      if (!compiled) {
+        error = std::format("[ERROR] {} Shader Compilation Failed.\n{}",
+                            stage_name(s), shader_log(s));
+        break;
+      }
+    }
+    if (error.empty())
+      error = std::format("[ERROR] Program Link Failed.\n{}",
+                          program_log(j.program));
+  } else if (!j.separable) {
+    // a lone stage is validated with the rest of its pipeline
+    glValidateProgram(j.program);
+    int valid = 0;
+    glGetProgramiv(j.program, GL_VALIDATE_STATUS, &valid);
+    if (!valid)
+      error = std::format("[ERROR] Program Validation Failed.\n{}",
+                          program_log(j.program));
+  }
+
+  for (const auto s : j.shaders) {
+    glDetachShader(j.program, s);
+    glDeleteShader(s);
+  }
+  j.shaders.clear();
+  j.spent += elapsed(started);
+
+  if (!error.empty()) {
+    glDeleteProgram(j.program);
+    return std::unexpected(std::format("{} ({})", error, j.name));
+  }
+
+  // frames spent waiting in the queue aren't counted, a cache hit doesn't
+  // save those
+  program_cache::shared().store(j.program, j.key, j.spent);
+  return shader(j.program);
+}
+
+auto shader_compiler::poll() -> std::size_t {
+  std::vector<job> finished;
+  bool compiled = false; // without the extension, one blocking finish a call
+  for (auto it = jobs.begin(); it != jobs.end();) {
+    if ((!parallel && compiled && !it->shaders.empty()) || !done(*it)) {
+      ++it;
+      continue;
+    }
+    compiled |= !it->shaders.empty();
+    finished.push_back(std::move(*it));
+    it = jobs.erase(it);
+  }
+
+  // callbacks may submit, run them once `jobs` is consistent
+  for (auto &j : finished)
+    j.ready(finish(j));
+  return finished.size();
+}
+
+auto shader_compiler::wait() -> void {
+  while (!jobs.empty()) {
+    auto all = std::exchange(jobs, {});
+    for (auto &j : all)
+      j.ready(finish(j));
+  }
+}
+
+auto shader_compiler::pending() const noexcept -> std::size_t {
+  return jobs.size();
+}
+
+} // namespace derp
@@ -0,0 +1,173 @@
+//===-- Implementation header for shader compiler class -------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "glsl_preprocessor.hpp"
+#include "program_cache.hpp"
+#include "shader.hpp"
+
+#include <chrono>     // std::chrono::microseconds
+#include <cstddef>    // std::size_t
+#include <cstdint>    // uint32_t, uint64_t
+#include <expected>   // std::expected
+#include <filesystem> // std::filesystem::path
+#include <functional> // std::move_only_function
+#include <future>     // std::future
+#include <optional>   // std::optional
+#include <span>       // std::span
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+namespace derp {
+
+// a specialization constant of a SPIR-V stage, `value` holds its bits
+struct spec_constant {
+  uint32_t id; // layout(constant_id = id)
+  uint32_t value;
+};
+
+// Builds programs without waiting on the driver.
+//
+// submit() hands every stage to glCompileShader and links right away, none of
+// the status queries that would make the driver finish on the spot. With
+// GL_KHR_parallel_shader_compile the driver compiles on its own threads and
+// poll() asks GL_COMPLETION_STATUS_KHR, which never blocks, delivering the
+// programs that are done. Everything else keeps rendering meanwhile.
+//
+// Without the extension the status queries block, so poll() finishes one
+// program per call and the stalls spread over frames. Programs found in the
+// program cache skip compiling and are delivered on the next poll().
+//
+// Separable stages come from SPIR-V compiled at build time when there is a
+// module for them and the driver has GL 4.6, skipping the driver's GLSL
+// front end; specialization constants then take the place of defines.
+// Everything else, and everything when the build had no glslangValidator,
+// compiles from GLSL. Linked programs always do: their uniforms are looked up
+// by name, and SPIR-V programs needn't report names.
+class shader_compiler {
+public:
+  using result = std::expected<shader, std::string>;
+  using ready_callback = std::move_only_function<void(result)>;
+
+private:
+  struct job {
+    std::string name; // the stage paths, for messages
+    uint32_t program;
+    std::vector<uint32_t> shaders; // empty when loaded from the cache
+    uint64_t key;                  // program cache key
+    bool separable;                // a stage of a program pipeline
+    std::chrono::microseconds spent; // in blocking GL calls, not queued
+    ready_callback ready;
+  };
+
+  std::vector<job> jobs; // in submission order
+  bool parallel;
+  bool spirv;
+  glsl_preprocessor preprocessor;
+  std::vector<std::filesystem::path> files_read; // see take_files()
+  std::vector<std::filesystem::path> stale;      // see mark_stale()
+
+  // a job for a new, empty program of `key`
+  [[nodiscard]]
+  static auto begin(uint64_t key, std::string name, bool separable,
+                    ready_callback ready) -> job;
+
+  // the build time SPIR-V module of the shader at `path`, if there is one
+  // and it can be used
+  [[nodiscard]]
+  auto spirv_module(const std::string &path) const
+      -> std::optional<std::filesystem::path>;
+
+  // true if `j` can be finished without blocking
+  [[nodiscard]]
+  auto done(const job &j) const -> bool;
+
+  auto start(std::span<const shader_stage> stages, std::string name,
+             bool separable, ready_callback ready) -> void;
+
+  // checks the link, stores it in the cache and hands over the program
+  [[nodiscard]]
+  static auto finish(job &j) -> result;
+
+public:
+  shader_compiler();
+  ~shader_compiler();
+
+  shader_compiler(const shader_compiler &) = delete;
+  shader_compiler &operator=(const shader_compiler &) = delete;
+
+  // whether the driver compiles in the background
+  [[nodiscard]]
+  static auto supported() -> bool;
+
+  // whether stages may come from SPIR-V, the build made modules and the
+  // driver can load them
+  [[nodiscard]]
+  static auto spirv_supported() -> bool;
+
+  // resolves #include and injects defines for the path based submits
+  [[nodiscard]]
+  auto get_preprocessor() noexcept -> glsl_preprocessor &;
+
+  // every file the path based submits read since the last call, includes
+  // too, for shader_reloader
+  [[nodiscard]]
+  auto take_files() -> std::vector<std::filesystem::path>;
+
+  // builds the stage at `path` from GLSL from now on, its SPIR-V module was
+  // compiled from a source that has since changed
+  auto mark_stale(const std::filesystem::path &path) -> void;
+
+  // starts building a program from `stages`, `ready` gets it or the log
+  auto submit(std::span<const shader_stage> stages, std::string name,
+              ready_callback ready) -> void;
+
+  // starts building a vertex + fragment program read from disk, with
+  // `defines` set in both stages. throws std::runtime_error if a file or an
+  // include can't be read
+  auto submit(const std::string &vert_path, const std::string &frag_path,
+              std::span<const std::string> defines, ready_callback ready)
+      -> void;
+  auto submit(const std::string &vert_path, const std::string &frag_path,
+              ready_callback ready) -> void;
+
+  // starts building a GL_PROGRAM_SEPARABLE program of the one stage in
+  // `path`, to be combined with others through pipeline_cache. from its
+  // SPIR-V module specialised with `constants` if there is one, from GLSL
+  // with `defines` if not; the two should describe the same variant.
+  // `from_source` skips the module, for defines no constant can stand in for
+  auto submit_stage(uint32_t type, const std::string &path,
+                    std::span<const std::string> defines,
+                    std::span<const spec_constant> constants,
+                    ready_callback ready, bool from_source = false) -> void;
+
+  // starts building a compute program read from disk, for compute_program
+  auto submit_compute(const std::string &path,
+                      std::span<const std::string> defines,
+                      ready_callback ready) -> void;
+
+  // the same, the future throws std::runtime_error if the build failed
+  [[nodiscard]]
+  auto submit(const std::string &vert_path, const std::string &frag_path)
+      -> std::future<shader>;
+
+  // delivers finished programs, returns how many. callbacks run here, on the
+  // calling thread, and may submit more
+  auto poll() -> std::size_t;
+
+  // blocks until everything submitted so far is delivered
+  auto wait() -> void;
+
+  // programs submitted but not delivered yet
+  [[nodiscard]]
+  auto pending() const noexcept -> std::size_t;
+}; // class shader_compiler
+
+} // namespace derp
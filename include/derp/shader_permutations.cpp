@@ -0,0 +1,89 @@
+//===-- Implementation of shader permutations class -----------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shader_permutations.hpp"
+
+#include <cassert> // assert
+#include <print>   // std::println
+#include <utility> // std::move
+
+namespace derp {
+
+shader_permutations::shader_permutations(
+    shader_compiler &compiler, std::string vert_path, std::string frag_path,
+    std::vector<std::string> feature_names)
+    : compiler(compiler), vert_path(std::move(vert_path)),
+      frag_path(std::move(frag_path)),
+      feature_names(std::move(feature_names)) {
+  assert(this->feature_names.size() <= 32);
+}
+
+shader_permutations::shader_permutations(
+    shader_compiler &compiler, const uint32_t stage, std::string path,
+    std::vector<std::string> feature_names, const features source_only)
+    : compiler(compiler), stage(stage), vert_path(std::move(path)),
+      feature_names(std::move(feature_names)), source_only(source_only) {
+  assert(this->feature_names.size() <= 32);
+}
+
+auto shader_permutations::build(const features set,
+                                std::shared_ptr<variant> slot) -> void {
+  // feature i is a define in GLSL, constant_id i in SPIR-V. source only
+  // features have no constant in the module
+  std::vector<std::string> defines;
+  std::vector<spec_constant> constants;
+  for (std::size_t i = 0; i < feature_names.size(); ++i) {
+    const uint32_t on = set >> i & 1u;
+    if (on)
+      defines.push_back(feature_names[i]);
+    if (!(source_only >> i & 1u))
+      constants.push_back({static_cast<uint32_t>(i), on});
+  }
+
+  // a failed build leaves the program it would have replaced
+  auto ready = [slot = std::move(slot)](shader_compiler::result built) {
+    if (!built) {
+      std::println("{}", built.error());
+      return;
+    }
+    slot->program = std::move(*built);
+  };
+  if (stage)
+    compiler.submit_stage(stage, vert_path, defines, constants,
+                          std::move(ready), (set & source_only) != 0);
+  else
+    compiler.submit(vert_path, frag_path, defines, std::move(ready));
+}
+
+auto shader_permutations::prepare(const std::span<const features> sets)
+    -> void {
+  for (const auto set : sets) {
+    auto [it, inserted] = variants.try_emplace(set);
+    if (!inserted)
+      continue;
+    it->second = std::make_shared<variant>();
+    build(set, it->second);
+  }
+}
+
+auto shader_permutations::rebuild() -> void {
+  for (const auto &[set, slot] : variants)
+    build(set, slot);
+}
+
+auto shader_permutations::get(const features set) -> const shader * {
+  const auto it = variants.find(set);
+  if (it == variants.end()) {
+    prepare({&set, 1});
+    return nullptr;
+  }
+  return it->second->program ? &*it->second->program : nullptr;
+}
+
+} // namespace derp
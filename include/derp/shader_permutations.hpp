@@ -0,0 +1,85 @@
+//===-- Implementation header for shader permutations class ---------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "shader.hpp"
+#include "shader_compiler.hpp"
+
+#include <cstdint>       // uint32_t
+#include <memory>        // std::shared_ptr
+#include <optional>      // std::optional
+#include <span>          // std::span
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+namespace derp {
+
+// Every variant of one vertex + fragment pair, built on demand.
+//
+// A variant is a set of features, bit i of the mask turning on
+// `#define feature_names[i]` in both stages. Built programs are kept by
+// their mask, so toggling a feature back and forth swaps between programs
+// already linked; nothing compiles in the frame loop once the variants in use
+// have been prepare()d. On disk the program cache keys every variant by its
+// preprocessed source, defines included.
+//
+// Built from a single stage instead, every variant is a separable program,
+// paired with the other stage at draw time through pipeline_cache. A feature
+// that only touches that stage then costs no extra program for the other.
+// Separable stages may come from SPIR-V, where feature i is specialization
+// constant i instead of a define; shaders handle both, see material.frag.
+// Features that change declarations (sampler types, extensions) can't be
+// constants: pass them as `source_only`, variants using any of them build
+// from GLSL.
+class shader_permutations {
+public:
+  using features = uint32_t;
+
+private:
+  struct variant {
+    std::optional<shader> program; // empty while it builds, or if it failed
+  };
+
+  shader_compiler &compiler;
+  uint32_t stage = 0;    // GL_*_SHADER when separable, 0 when linked
+  std::string vert_path; // or the one stage's path
+  std::string frag_path;
+  std::vector<std::string> feature_names;
+  features source_only = 0;
+  // shared with the compiler callbacks, which may outlive this
+  std::unordered_map<features, std::shared_ptr<variant>> variants;
+
+  auto build(features set, std::shared_ptr<variant> slot) -> void;
+
+public:
+  shader_permutations(shader_compiler &compiler, std::string vert_path,
+                      std::string frag_path,
+                      std::vector<std::string> feature_names);
+
+  // variants of the single `stage` in `path`, as separable programs
+  shader_permutations(shader_compiler &compiler, uint32_t stage,
+                      std::string path, std::vector<std::string> feature_names,
+                      features source_only = 0);
+
+  // starts building every variant of `sets` not built or building yet
+  auto prepare(std::span<const features> sets) -> void;
+
+  // builds every variant again, each keeps its program until the new one is
+  // ready, and for good if the new one fails
+  auto rebuild() -> void;
+
+  // the program of `set`, nullptr while it builds or if it failed to. the
+  // first call for a set starts building it
+  [[nodiscard]]
+  auto get(features set) -> const shader *;
+}; // class shader_permutations
+
+} // namespace derp
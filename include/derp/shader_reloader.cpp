@@ -0,0 +1,145 @@
+//===-- Implementation of shader reloader class ---------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "shader_reloader.hpp"
+
+#include <algorithm> // std::ranges::any_of, std::ranges::find
+#include <array>     // std::array
+#include <print>     // std::println
+#include <stdexcept> // std::runtime_error
+#include <utility>   // std::move
+
+#ifdef __linux__
+#include <sys/inotify.h> // inotify_init1, inotify_add_watch
+#include <unistd.h>      // read, close
+#define DERP_INOTIFY 1
+#endif
+
+namespace derp {
+
+namespace {
+
+auto normalised(const std::filesystem::path &path) -> std::filesystem::path {
+  std::error_code ec;
+  const auto absolute = std::filesystem::absolute(path, ec);
+  return (ec ? path : absolute).lexically_normal();
+}
+
+} // namespace
+
+shader_reloader::shader_reloader(shader_compiler &compiler,
+                                 const std::filesystem::path &dir)
+    : compiler(compiler) {
+#ifdef DERP_INOTIFY
+  fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    std::println("[ERROR] Couldn't start inotify, shaders won't reload.");
+    return;
+  }
+
+  // editors that save through a rename show up as IN_MOVED_TO
+  const auto watch = [this](const std::filesystem::path &d) {
+    const int wd =
+        ::inotify_add_watch(fd, d.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd >= 0)
+      dirs.emplace(wd, normalised(d));
+  };
+  watch(dir);
+  std::error_code ec;
+  for (const auto &e :
+       std::filesystem::recursive_directory_iterator(dir, ec))
+    if (e.is_directory(ec))
+      watch(e.path());
+#else
+  (void)dir;
+#endif
+}
+
+shader_reloader::~shader_reloader() {
+#ifdef DERP_INOTIFY
+  if (fd >= 0)
+    ::close(fd); // drops the watches with it
+#endif
+}
+
+auto shader_reloader::track(std::function<void()> rebuild) -> void {
+  entry e{.files = {}, .rebuild = std::move(rebuild)};
+  for (const auto &file : compiler.take_files())
+    e.files.push_back(normalised(file));
+  entries.push_back(std::move(e));
+}
+
+auto shader_reloader::read_changes() -> std::vector<std::filesystem::path> {
+  std::vector<std::filesystem::path> changed;
+#ifdef DERP_INOTIFY
+  if (fd < 0)
+    return changed;
+
+  alignas(inotify_event) std::array<char, 4096> buffer;
+  for (;;) {
+    const auto length = ::read(fd, buffer.data(), buffer.size());
+    if (length <= 0)
+      break; // EAGAIN, nothing more for now
+    for (std::size_t offset = 0; offset < static_cast<std::size_t>(length);) {
+      const auto *event =
+          reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+      offset += sizeof(inotify_event) + event->len;
+
+      const auto it = dirs.find(event->wd);
+      if (it == dirs.end() || event->len == 0)
+        continue;
+      auto path = it->second / event->name;
+      if (std::ranges::find(changed, path) == changed.end())
+        changed.push_back(std::move(path));
+    }
+  }
+#endif
+  return changed;
+}
+
+auto shader_reloader::poll() -> std::size_t {
+  const auto changed = read_changes();
+  if (changed.empty())
+    return 0;
+
+  std::size_t rebuilt = 0;
+  for (auto &e : entries) {
+    const bool affected = std::ranges::any_of(changed, [&](const auto &f) {
+      return std::ranges::find(e.files, f) != e.files.end();
+    });
+    if (!affected)
+      continue;
+
+    for (const auto &f : changed)
+      if (std::ranges::find(e.files, f) != e.files.end())
+        std::println("[INFO] {} changed, rebuilding.", f.string());
+    // the build's SPIR-V modules were compiled from the old sources, other
+    // builds keep theirs
+    for (const auto &f : e.files)
+      compiler.mark_stale(f);
+
+    // a file that can't be read now throws, the old program stays
+    try {
+      (void)compiler.take_files();
+      e.rebuild();
+    } catch (const std::runtime_error &error) {
+      std::println("{}", error.what());
+    }
+    // includes may have come or gone
+    if (auto files = compiler.take_files(); !files.empty()) {
+      e.files.clear();
+      for (const auto &file : files)
+        e.files.push_back(normalised(file));
+    }
+    ++rebuilt;
+  }
+  return rebuilt;
+}
+
+} // namespace derp
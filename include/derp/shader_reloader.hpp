@@ -0,0 +1,70 @@
+//===-- Implementation header for shader reloader class -------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "shader_compiler.hpp"
+
+#include <cstddef>       // std::size_t
+#include <filesystem>    // std::filesystem::path
+#include <functional>    // std::function
+#include <string_view>   // std::string_view
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+namespace derp {
+
+// Rebuilds programs whose sources change on disk, while the app runs.
+//
+// inotify watches the shader directory and its subdirectories; poll() reads
+// what changed without blocking and resubmits every build that read one of
+// the changed files, through the compiler like any other build. The new
+// programs arrive from shader_compiler::poll(), at the top of a frame, and
+// replace the old ones in the build's callback; a build that fails leaves the
+// old program running. Fresh programs come with fresh reflection tables and
+// program cache entries, pipelines of the old ones are dropped.
+//
+// Only on Linux, elsewhere nothing is ever reported changed.
+class shader_reloader {
+public:
+  static constexpr std::string_view DEFAULT_DIR = RESOURCES_PATH "/shaders";
+
+private:
+  struct entry {
+    std::vector<std::filesystem::path> files; // absolute, normalised
+    std::function<void()> rebuild;
+  };
+
+  shader_compiler &compiler;
+  int fd = -1;
+  std::unordered_map<int, std::filesystem::path> dirs; // watch, directory
+  std::vector<entry> entries;
+
+  // the files changed since the last call
+  [[nodiscard]]
+  auto read_changes() -> std::vector<std::filesystem::path>;
+
+public:
+  explicit shader_reloader(shader_compiler &compiler,
+                           const std::filesystem::path &dir = DEFAULT_DIR);
+  ~shader_reloader();
+
+  shader_reloader(const shader_reloader &) = delete;
+  shader_reloader &operator=(const shader_reloader &) = delete;
+
+  // `rebuild` resubmits what was submitted to the compiler since the last
+  // track(), it runs whenever a file those builds read changes
+  auto track(std::function<void()> rebuild) -> void;
+
+  // resubmits the builds affected by changes, returns how many. call once a
+  // frame, before shader_compiler::poll()
+  auto poll() -> std::size_t;
+}; // class shader_reloader
+
+} // namespace derp
@@ -0,0 +1,102 @@
+//===-- Implementation of staging buffer class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "staging_buffer.hpp"
+
+#include <algorithm> // std::erase_if, std::ranges::any_of
+#include <format>    // std::format
+#include <stdexcept> // std::runtime_error
+
+namespace derp {
+
+staging_buffer::staging_buffer(const std::size_t capacity)
+    : capacity(capacity) {
+  constexpr GLbitfield flags =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+  glCreateBuffers(1, &id);
+  glNamedBufferStorage(id, static_cast<GLsizeiptr>(capacity), nullptr, flags);
+
+  mapped = static_cast<std::byte *>(glMapNamedBufferRange(
+      id, 0, static_cast<GLsizeiptr>(capacity), flags));
+
+  if (!mapped) {
+    glDeleteBuffers(1, &id);
+    throw std::runtime_error(std::format(
+        "[ERROR] Couldn't map {} byte staging buffer.", capacity));
+  }
+}
+
+staging_buffer::~staging_buffer() {
+  for (const auto &r : in_flight) {
+    if (r.fence)
+      glDeleteSync(r.fence);
+  }
+  if (id) {
+    glUnmapNamedBuffer(id);
+    glDeleteBuffers(1, &id);
+  }
+}
+
+auto staging_buffer::reclaim() -> void {
+  std::erase_if(in_flight, [](const region &r) {
+    if (!r.fence)
+      return false;
+    int status = GL_UNSIGNALED;
+    glGetSynciv(r.fence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED)
+      return false;
+    glDeleteSync(r.fence);
+    return true;
+  });
+}
+
+auto staging_buffer::allocate(const std::size_t size,
+                              const std::size_t alignment)
+    -> std::optional<std::size_t> {
+  if (size > capacity)
+    return std::nullopt;
+
+  reclaim();
+
+  std::size_t begin = (head + alignment - 1) / alignment * alignment;
+  if (begin + size > capacity)
+    begin = 0; // wrap around
+
+  const std::size_t end = begin + size;
+  const bool busy = std::ranges::any_of(in_flight, [&](const region &r) {
+    return begin < r.end && r.begin < end;
+  });
+  if (busy)
+    return std::nullopt;
+
+  in_flight.push_back({begin, end, nullptr});
+  head = end;
+  return begin;
+}
+
+auto staging_buffer::fence() -> void {
+  for (auto &r : in_flight) {
+    if (!r.fence)
+      r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+}
+
+auto staging_buffer::data(const std::size_t offset) const noexcept
+    -> std::byte * {
+  return mapped + offset;
+}
+
+auto staging_buffer::get_id() const noexcept -> uint32_t { return id; }
+
+auto staging_buffer::get_capacity() const noexcept -> std::size_t {
+  return capacity;
+}
+
+} // namespace derp
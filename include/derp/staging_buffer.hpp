@@ -0,0 +1,68 @@
+//===-- Implementation header for staging buffer class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>  // std::byte, std::size_t
+#include <cstdint>  // uint32_t
+#include <optional> // std::optional
+#include <vector>   // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+// Persistently mapped ring buffer used as the source of pixel unpack (and
+// buffer copy) transfers. The CPU writes straight into the mapping, the GPU
+// reads from it, and fences keep the CPU from overwriting bytes the GPU has
+// not consumed yet.
+class staging_buffer {
+private:
+  struct region {
+    std::size_t begin;
+    std::size_t end;
+    GLsync fence; // nullptr until fence() is called
+  };
+
+  uint32_t id = 0;
+  std::byte *mapped = nullptr;
+  std::size_t capacity;
+  std::size_t head = 0;
+  std::vector<region> in_flight;
+
+  auto reclaim() -> void;
+
+public:
+  explicit staging_buffer(std::size_t capacity);
+  ~staging_buffer();
+
+  staging_buffer(const staging_buffer &) = delete;
+  staging_buffer &operator=(const staging_buffer &) = delete;
+
+  // returns the offset of `size` free bytes, or nothing when the GPU still
+  // reads that part of the ring. never blocks.
+  [[nodiscard]]
+  auto allocate(std::size_t size, std::size_t alignment = 16)
+      -> std::optional<std::size_t>;
+
+  // guards every allocation since the last call with a fence, call after the
+  // GL commands reading them were issued
+  auto fence() -> void;
+
+  [[nodiscard]]
+  auto data(std::size_t offset) const noexcept -> std::byte *;
+
+  [[nodiscard]]
+  auto get_id() const noexcept -> uint32_t;
+
+  [[nodiscard]]
+  auto get_capacity() const noexcept -> std::size_t;
+}; // class staging_buffer
+
+} // namespace derp
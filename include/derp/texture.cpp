@@ -9,55 +9,278 @@
 //===----------------------------------------------------------------------===//
 
 #include "texture.hpp"
+#include "gl_state.hpp"
+#include "image.hpp"
+#include "pixel_convert.hpp"
 
+#include <algorithm>
+#include <array>
 #include <format>
 #include <glad/glad.h>
-#include <stb/stb_image.h>
 #include <stdexcept>
+#include <vector>
 
 namespace derp {
 
-texture::texture(const std::string &texture_path, const texture_type _type)
-    : _type(_type) {
-  int w, h, n;
-  stbi_set_flip_vertically_on_load(true);
+auto internal_format(const texel_format &format) -> uint32_t {
+  const bool srgb = format.srgb;
+  switch (format.block) {
+  case block_format::BC1:
+    return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+                : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+  case block_format::BC3:
+    return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+                : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+  case block_format::BC4:
+    return GL_COMPRESSED_RED_RGTC1;
+  case block_format::BC5:
+    return GL_COMPRESSED_RG_RGTC2;
+  case block_format::BC7:
+    return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+                : GL_COMPRESSED_RGBA_BPTC_UNORM;
+  default:
+    break;
+  }
 
-  unsigned char *data = stbi_load(texture_path.data(), &w, &h, &n, 0);
+  constexpr std::array<uint32_t, 4> unorm{GL_R8, GL_RG8, GL_RGB8, GL_RGBA8};
+  constexpr std::array<uint32_t, 4> half{GL_R16F, GL_RG16F, GL_RGB16F,
+                                         GL_RGBA16F};
+  constexpr std::array<uint32_t, 4> full{GL_R32F, GL_RG32F, GL_RGB32F,
+                                         GL_RGBA32F};
+  const auto i = static_cast<std::size_t>(std::clamp(format.channels, 1, 4));
 
-  if (!data) {
-    throw std::runtime_error(
-        std::string(std::format("[ERROR] file not found {}", texture_path)));
+  switch (format.type) {
+  case pixel_type::HALF:
+    return half[i - 1];
+  case pixel_type::FLOAT:
+    return full[i - 1];
+  case pixel_type::R11G11B10F:
+    return GL_R11F_G11F_B10F;
+  default:
+    if (srgb && i == 3)
+      return GL_SRGB8;
+    if (srgb && i == 4)
+      return GL_SRGB8_ALPHA8;
+    return unorm[i - 1];
   }
+}
 
-  glCreateTextures(GL_TEXTURE_2D, 1, &id);
+auto pixel_format(const int channels) -> uint32_t {
+  constexpr std::array<uint32_t, 4> formats{GL_RED, GL_RG, GL_RGB, GL_RGBA};
+  return formats[static_cast<std::size_t>(std::clamp(channels, 1, 4)) - 1];
+}
 
-  glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-  glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+auto pixel_data_type(const pixel_type type) -> uint32_t {
+  switch (type) {
+  case pixel_type::HALF:
+    return GL_HALF_FLOAT;
+  case pixel_type::FLOAT:
+    return GL_FLOAT;
+  case pixel_type::R11G11B10F:
+    return GL_UNSIGNED_INT_10F_11F_11F_REV;
+  default:
+    return GL_UNSIGNED_BYTE;
+  }
+}
 
-  const auto img_format = (n == 4) ? GL_RGBA : GL_RGB;
-  const auto gl_format = (n == 4) ? GL_RGBA8 : GL_RGB8;
+auto texture::is_colour(const texture_type type) noexcept -> bool {
+  using enum texture_type;
+  return type == DIFFUSE || type == AMBIENT || type == SPECULAR;
+}
 
-  glTextureStorage2D(id, 1, gl_format, w, h);
-  glTextureSubImage2D(id, 0, 0, 0, w, h, img_format, GL_UNSIGNED_BYTE, data);
+texture::texture(const std::string &texture_path, const texture_type _type)
+    : _type(_type) {
+  auto img = load_image(texture_path);
 
-  stbi_image_free(data);
-  deleted = false;
+  if (!img) {
+    throw std::runtime_error(std::string(std::format(
+        "[ERROR] couldn't load {}: {}", texture_path, img.error())));
+  }
+
+  // uploaded straight from the decoder's buffer unless the format has to
+  // change
+  img->srgb = is_colour(_type) && img->type == pixel_type::UNORM8;
+  negotiate_format(*img);
+
+  const auto &base = img->levels.front();
+  allocate(base.width, base.height, img->format());
+  upload(0, base.pixels.get());
+  generate_mips();
 }
 
+texture::texture(const texture_type _type) : _type(_type) {}
+
 texture::~texture() {
   if (deleted)
     return;
   if (glIsTexture(id)) {
     deleted = true;
+    release_handle();
+    gl_state::shared().forget_texture(id);
     glDeleteTextures(1, &id);
     // std::println("[DEBUG] texture with id = {} deleted", id);
   }
 }
 
+auto texture::allocate(const int w, const int h, const texel_format &f,
+                       const int l) -> void {
+  const int count = l > 0 ? l : mip_count(w, h);
+  adopt(create_storage(w, h, count, f), w, h, count, f);
+}
+
+auto texture::create_storage(const int w, const int h, const int l,
+                             const texel_format &f) -> uint32_t {
+  uint32_t id = 0;
+  glCreateTextures(GL_TEXTURE_2D, 1, &id);
+  glTextureStorage2D(id, l, internal_format(f), w, h);
+  return id;
+}
+
+auto texture::reallocate(const int w, const int h, const int l,
+                         const int shift) -> void {
+  if (deleted)
+    return;
+
+  const uint32_t next = create_storage(w, h, l, format);
+  copy_levels(next, w, h, l, shift);
+  adopt(next, w, h, l, format);
+  set_base_level(std::max(0, shift));
+}
+
+auto texture::copy_levels(const uint32_t next, const int w, const int h,
+                          const int l, const int shift) const -> void {
+  for (int level = std::max(0, shift); level < l; ++level) {
+    const int src = level - shift;
+    if (src >= levels)
+      break;
+    // GPU side copy, works for compressed formats as well
+    glCopyImageSubData(id, GL_TEXTURE_2D, src, 0, 0, 0, next, GL_TEXTURE_2D,
+                       level, 0, 0, 0, std::max(1, w >> level),
+                       std::max(1, h >> level), 1);
+  }
+}
+
+auto texture::adopt(const uint32_t storage, const int w, const int h,
+                    const int l, const texel_format &f) -> void {
+  if (!deleted) {
+    release_handle();
+    gl_state::shared().forget_texture(id);
+    glDeleteTextures(1, &id);
+  }
+
+  id = storage;
+  width = w;
+  height = h;
+  levels = l;
+  format = f;
+  deleted = false;
+}
+
+auto texture::set_base_level(const int level) const -> void {
+  glTextureParameteri(id, GL_TEXTURE_BASE_LEVEL, level);
+}
+
+auto texture::upload(const int level, const void *pixels,
+                     const std::size_t size) const -> void {
+  write_rows(id, format, level, std::max(1, width >> level), 0,
+             std::max(1, height >> level), pixels, size);
+}
+
+auto texture::write_rows(const uint32_t id, const texel_format &f,
+                         const int level, const int w, const int y,
+                         const int h, const void *pixels,
+                         const std::size_t size) -> void {
+  if (f.block != block_format::NONE) {
+    glCompressedTextureSubImage2D(id, level, 0, y, w, h, internal_format(f),
+                                  static_cast<GLsizei>(size), pixels);
+    return;
+  }
+
+  // rows of 1 to 3 channel images are not 4 byte aligned
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTextureSubImage2D(id, level, 0, y, w, h, pixel_format(f.channels),
+                      pixel_data_type(f.type), pixels);
+}
+
+auto texture::generate_mips() const -> void {
+  // GL can't render into compressed formats, those ship their own chain
+  if (levels > 1 && format.block == block_format::NONE)
+    glGenerateTextureMipmap(id);
+}
+
+auto texture::release_handle() -> void {
+  if (handle && glIsTextureHandleResidentARB(handle))
+    glMakeTextureHandleNonResidentARB(handle);
+  handle = 0;
+}
+
+auto texture::placeholder(const texture_type type) -> uint32_t {
+  // never freed, they live as long as the context
+  static std::array<uint32_t, TEXTURE_TYPES> ids{};
+
+  auto &id = ids[static_cast<size_t>(type)];
+  if (id)
+    return id;
+
+  // flat normal for normal maps, unoccluded, rough and dielectric for ORM,
+  // neutral white for everything else
+  constexpr std::array<unsigned char, 4> flat_normal{128, 128, 255, 255};
+  constexpr std::array<unsigned char, 4> orm{255, 255, 0, 255};
+  constexpr std::array<unsigned char, 4> white{255, 255, 255, 255};
+  const auto &texel =
+      type == texture_type::NORMAL || type == texture_type::NORMAL_HEIGHT
+          ? flat_normal
+          : (type == texture_type::ORM ? orm : white);
+
+  glCreateTextures(GL_TEXTURE_2D, 1, &id);
+  glTextureStorage2D(id, 1, GL_RGBA8, 1, 1);
+  glTextureSubImage2D(id, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                      texel.data());
+  return id;
+}
+
 auto texture::use(const uint32_t unit) const -> void {
-  glBindTextureUnit(unit, id);
+  auto &state = gl_state::shared();
+  state.bind_texture(unit, deleted ? placeholder(_type) : id);
+  state.bind_sampler(unit, sampler_cache::shared().get(sampler));
+}
+
+auto texture::use_all(const uint32_t first,
+                      const std::span<const texture *const> textures)
+    -> void {
+  auto &cache = sampler_cache::shared();
+  std::vector<uint32_t> ids;
+  std::vector<uint32_t> samplers;
+  ids.reserve(textures.size());
+  samplers.reserve(textures.size());
+
+  for (const auto *tex : textures) {
+    ids.push_back(tex->deleted ? placeholder(tex->_type) : tex->id);
+    samplers.push_back(cache.get(tex->sampler));
+  }
+
+  auto &state = gl_state::shared();
+  state.bind_textures(first, ids);
+  state.bind_samplers(first, samplers);
+}
+
+auto texture::set_sampler(const sampler_desc &desc) noexcept -> void {
+  sampler = desc;
+}
+
+auto texture::get_sampler() const noexcept -> const sampler_desc & {
+  return sampler;
+}
+
+auto texture::is_ready() const noexcept -> bool { return !deleted; }
+
+auto texture::get_handle() -> uint64_t {
+  if (deleted || !GLAD_GL_ARB_bindless_texture)
+    return 0;
+  if (!handle)
+    handle = glGetTextureSamplerHandleARB(
+        id, sampler_cache::shared().get(sampler));
+  return handle;
 }
 
 } // namespace derp
@@ -9,26 +9,143 @@
 
 #pragma once
 
+#include "image.hpp"
+#include "sampler_cache.hpp"
+
+#include <cstddef>
 #include <cstdint>
+#include <span>
 #include <string>
 
 namespace derp {
+
+// GL storage format of images in `format`. 1 and 2 channel sRGB has no GL
+// format and is stored linear, negotiate_format() widens those first.
+[[nodiscard]]
+auto internal_format(const texel_format &format) -> uint32_t;
+
+// client side format of uncompressed pixel transfers
+[[nodiscard]]
+auto pixel_format(int channels) -> uint32_t;
+
+// client side component type of uncompressed pixel transfers
+[[nodiscard]]
+auto pixel_data_type(pixel_type type) -> uint32_t;
+
 class texture {
 public:
-  enum class texture_type { AMBIENT, DIFFUSE, SPECULAR, NORMAL, HEIGHT };
+  // NORMAL_HEIGHT and ORM are packed at import, see channel_pack and
+  // material
+  enum class texture_type {
+    AMBIENT,
+    DIFFUSE,
+    SPECULAR,
+    NORMAL,
+    HEIGHT,
+    NORMAL_HEIGHT, // normal xy in RG, height in A
+    ORM,           // occlusion, roughness, metalness
+  };
+  static constexpr std::size_t TEXTURE_TYPES = 7;
 
 private:
+  friend class bindless_table;
+  friend class texture_streamer;
+  friend class virtual_texture;
+
   uint32_t id = 0;
   bool deleted = true;
   texture_type _type;
 
+  int width = 0;
+  int height = 0;
+  int levels = 0;
+  texel_format format;
+  sampler_desc sampler;
+  uint64_t handle = 0; // bindless handle, created on demand
+
+  // colour textures are stored sRGB, the rest hold data
+  static auto is_colour(texture_type type) noexcept -> bool;
+
+  // drops the bindless handle's residency before the texture goes away
+  auto release_handle() -> void;
+
+  // immutable storage, the sampling state lives in sampler_cache
+  static auto create_storage(int w, int h, int l, const texel_format &f)
+      -> uint32_t;
+
+  // creates immutable storage for `l` levels, 0 for the full mip chain. the
+  // texture stops being a placeholder
+  auto allocate(int w, int h, const texel_format &f, int l = 0) -> void;
+
+  // swaps the storage for one of w x h with `l` levels, old level i becomes
+  // level i + shift: positive to make room for finer levels, negative to
+  // drop the finest ones. kept levels are copied on the GPU, levels below
+  // `shift` are hidden behind GL_TEXTURE_BASE_LEVEL until they are uploaded
+  // and set_base_level() uncovers them.
+  auto reallocate(int w, int h, int l, int shift) -> void;
+  auto set_base_level(int level) const -> void;
+
+  // GPU copy of the current levels into `next` (w x h, `l` levels), old
+  // level i lands in level i + shift
+  auto copy_levels(uint32_t next, int w, int h, int l, int shift) const
+      -> void;
+
+  // takes over storage made by create_storage(), the old storage goes away
+  // and the texture stops being a placeholder
+  auto adopt(uint32_t storage, int w, int h, int l, const texel_format &f)
+      -> void;
+
+  // writes rows [y, y + h) of a level `w` texels wide of the storage `id`,
+  // for compressed formats y is a multiple of 4. `pixels` as for upload().
+  static auto write_rows(uint32_t id, const texel_format &f, int level, int w,
+                         int y, int h, const void *pixels, std::size_t size)
+      -> void;
+
+  // `pixels` is a client pointer, or an offset into the bound
+  // GL_PIXEL_UNPACK_BUFFER. `size` is only read for compressed textures.
+  auto upload(int level, const void *pixels, std::size_t size = 0) const
+      -> void;
+
+  // fills every level below the base on the GPU, for images that were not
+  // imported with a mip chain
+  auto generate_mips() const -> void;
+
+  // 1x1 texture bound in place of textures that are still streaming in
+  static auto placeholder(texture_type type) -> uint32_t;
+
 public:
   explicit texture(const std::string &texture_path,
                    texture_type _type = texture_type::DIFFUSE);
 
+  // empty texture, samples as a placeholder until the streamer fills it
+  explicit texture(texture_type _type);
+
+  texture(const texture &) = delete;
+  texture &operator=(const texture &) = delete;
+
   ~texture();
 
+  // binds the texture and its shared sampler
   auto use(uint32_t unit = 0) const -> void;
 
+  // binds textures[i] to unit first + i with two calls for all of them
+  static auto use_all(uint32_t first, std::span<const texture *const> textures)
+      -> void;
+
+  auto set_sampler(const sampler_desc &desc) noexcept -> void;
+
+  [[nodiscard]]
+  auto get_sampler() const noexcept -> const sampler_desc &;
+
+  [[nodiscard]]
+  auto is_ready() const noexcept -> bool;
+
+  // ARB_bindless_texture handle, 0 while the texture is still a placeholder
+  // or without the extension. made with the texture's sampler, whose state
+  // is frozen from then on, residency is up to the caller (see
+  // bindless_table).
+  [[nodiscard]]
+  auto get_handle() -> uint64_t;
+
 }; // class texture
 } // namespace derp
@@ -0,0 +1,106 @@
+//===-- Implementation of texture array class -----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "texture_array.hpp"
+#include "gl_state.hpp"
+#include "sampler_cache.hpp"
+#include "texture.hpp"
+
+#include <algorithm> // std::max
+
+#include <glad/glad.h>
+
+namespace derp {
+
+texture_array::texture_array(const int width, const int height,
+                             const texel_format &format, const int levels,
+                             const uint32_t initial_layers)
+    : width(width), height(height), format(format), levels(levels) {
+  grow(std::max(1u, initial_layers));
+}
+
+texture_array::~texture_array() {
+  if (!id)
+    return;
+  gl_state::shared().forget_texture(id);
+  glDeleteTextures(1, &id);
+}
+
+auto texture_array::grow(const uint32_t layers) -> void {
+  uint32_t next = 0;
+  glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &next);
+
+  glTextureStorage3D(next, levels, internal_format(format), width, height,
+                     static_cast<GLsizei>(layers));
+
+  if (id) {
+    // GPU side copy, works for compressed formats as well
+    for (int level = 0; level < levels; ++level) {
+      glCopyImageSubData(id, GL_TEXTURE_2D_ARRAY, level, 0, 0, 0, next,
+                         GL_TEXTURE_2D_ARRAY, level, 0, 0, 0,
+                         std::max(1, width >> level),
+                         std::max(1, height >> level),
+                         static_cast<GLsizei>(count));
+    }
+    gl_state::shared().forget_texture(id);
+    glDeleteTextures(1, &id);
+  }
+
+  id = next;
+  capacity = layers;
+}
+
+auto texture_array::add_layer() -> uint32_t {
+  if (count == capacity)
+    grow(capacity * 2);
+  return count++;
+}
+
+auto texture_array::upload(const uint32_t layer, const int level,
+                           const int x, const int y, const int w, const int h,
+                           const void *pixels, const std::size_t size) const
+    -> void {
+  const auto z = static_cast<GLint>(layer);
+  if (format.block != block_format::NONE) {
+    glCompressedTextureSubImage3D(id, level, x, y, z, w, h, 1,
+                                  internal_format(format),
+                                  static_cast<GLsizei>(size), pixels);
+    return;
+  }
+
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTextureSubImage3D(id, level, x, y, z, w, h, 1,
+                      pixel_format(format.channels),
+                      pixel_data_type(format.type), pixels);
+}
+
+auto texture_array::use(const uint32_t unit) const -> void {
+  auto &state = gl_state::shared();
+  state.bind_texture(unit, id);
+  state.bind_sampler(unit, sampler_cache::shared().get({}));
+}
+
+auto texture_array::matches(const int w, const int h, const texel_format &f,
+                            const int l) const noexcept -> bool {
+  return width == w && height == h && format == f && levels == l;
+}
+
+auto texture_array::get_width() const noexcept -> int { return width; }
+
+auto texture_array::get_height() const noexcept -> int { return height; }
+
+auto texture_array::get_levels() const noexcept -> int { return levels; }
+
+auto texture_array::get_block() const noexcept -> block_format {
+  return format.block;
+}
+
+auto texture_array::get_layers() const noexcept -> uint32_t { return count; }
+
+} // namespace derp
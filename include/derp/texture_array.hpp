@@ -0,0 +1,76 @@
+//===-- Implementation header for texture array class ---------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+
+#include <cstddef> // std::size_t
+#include <cstdint> // uint32_t
+
+namespace derp {
+
+// Layers of equally sized, equally formatted images in one
+// GL_TEXTURE_2D_ARRAY, so they can all be sampled through a single binding.
+// The layer count grows by doubling, the old layers are copied over on the
+// GPU.
+class texture_array {
+private:
+  uint32_t id = 0;
+  int width;
+  int height;
+  texel_format format;
+  int levels;
+  uint32_t capacity = 0; // layers with storage
+  uint32_t count = 0;    // layers handed out
+
+  auto grow(uint32_t layers) -> void;
+
+public:
+  texture_array(int width, int height, const texel_format &format,
+                int levels, uint32_t initial_layers = 4);
+  ~texture_array();
+
+  texture_array(const texture_array &) = delete;
+  texture_array &operator=(const texture_array &) = delete;
+
+  // returns the index of a fresh layer, contents are undefined until
+  // uploaded
+  [[nodiscard]]
+  auto add_layer() -> uint32_t;
+
+  // writes a w x h region of one level of one layer. `pixels` is a client
+  // pointer or an offset into the bound GL_PIXEL_UNPACK_BUFFER, `size` is
+  // only read for compressed arrays.
+  auto upload(uint32_t layer, int level, int x, int y, int w, int h,
+              const void *pixels, std::size_t size = 0) const -> void;
+
+  auto use(uint32_t unit = 0) const -> void;
+
+  [[nodiscard]]
+  auto matches(int w, int h, const texel_format &f, int l) const noexcept
+      -> bool;
+
+  [[nodiscard]]
+  auto get_width() const noexcept -> int;
+
+  [[nodiscard]]
+  auto get_height() const noexcept -> int;
+
+  [[nodiscard]]
+  auto get_levels() const noexcept -> int;
+
+  [[nodiscard]]
+  auto get_block() const noexcept -> block_format;
+
+  [[nodiscard]]
+  auto get_layers() const noexcept -> uint32_t;
+}; // class texture_array
+
+} // namespace derp
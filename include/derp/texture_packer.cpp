@@ -0,0 +1,198 @@
+//===-- Implementation of texture packer class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "texture_packer.hpp"
+
+#include <algorithm> // std::max, std::min
+#include <limits>    // std::numeric_limits
+
+namespace derp {
+
+texture_packer::skyline::skyline(const int width, const int height)
+    : width(width), height(height), segments{{0, 0, width}} {}
+
+// height the rectangle would rest at when its left edge is on segment i
+auto texture_packer::skyline::fit(const std::size_t i, const int w,
+                                  const int h) const -> std::optional<int> {
+  if (segments[i].x + w > width)
+    return std::nullopt;
+
+  int y = 0;
+  int remaining = w;
+  for (std::size_t j = i; remaining > 0; ++j) {
+    if (j == segments.size())
+      return std::nullopt;
+    y = std::max(y, segments[j].y);
+    if (y + h > height)
+      return std::nullopt;
+    remaining -= segments[j].width;
+  }
+  return y;
+}
+
+auto texture_packer::skyline::pack(const int w, const int h)
+    -> std::optional<glm::ivec2> {
+  std::size_t best = segments.size();
+  int best_top = std::numeric_limits<int>::max();
+  int best_width = std::numeric_limits<int>::max();
+  int best_y = 0;
+
+  // lowest resulting top edge wins, ties go to the narrower segment
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    const auto y = fit(i, w, h);
+    if (!y)
+      continue;
+    const int top = *y + h;
+    if (top < best_top || (top == best_top && segments[i].width < best_width)) {
+      best = i;
+      best_top = top;
+      best_width = segments[i].width;
+      best_y = *y;
+    }
+  }
+
+  if (best == segments.size())
+    return std::nullopt;
+
+  const int x = segments[best].x;
+  segments.insert(segments.begin() + static_cast<std::ptrdiff_t>(best),
+                  {x, best_top, w});
+
+  // trim the segments the new one now shadows
+  for (std::size_t j = best + 1; j < segments.size();) {
+    const auto &prev = segments[j - 1];
+    auto &seg = segments[j];
+    const int overlap = prev.x + prev.width - seg.x;
+    if (overlap <= 0)
+      break;
+    seg.x += overlap;
+    seg.width -= overlap;
+    if (seg.width > 0)
+      break;
+    segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(j));
+  }
+
+  for (std::size_t j = 1; j < segments.size();) {
+    if (segments[j - 1].y == segments[j].y) {
+      segments[j - 1].width += segments[j].width;
+      segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(j));
+    } else {
+      ++j;
+    }
+  }
+
+  return glm::ivec2(x, best_y);
+}
+
+auto texture_packer::find_array(const int w, const int h,
+                                const texel_format &f, const int l,
+                                const bool atlas) -> uint32_t {
+  for (uint32_t i = 0; i < arrays.size(); ++i) {
+    if (arrays[i].atlas == atlas && arrays[i].array->matches(w, h, f, l))
+      return i;
+  }
+
+  // atlas layers are big, start them one at a time
+  arrays.push_back(
+      {std::make_unique<texture_array>(w, h, f, l, atlas ? 1 : 4), atlas});
+  return static_cast<uint32_t>(arrays.size() - 1);
+}
+
+auto texture_packer::reserve(const image &img)
+    -> std::optional<packed_texture> {
+  if (img.levels.empty())
+    return std::nullopt;
+
+  const auto &base = img.levels.front();
+  const auto available = static_cast<int>(img.levels.size());
+  packed_texture slot;
+
+  if (base.width > ATLAS_MAX_ENTRY || base.height > ATLAS_MAX_ENTRY) {
+    const int levels = mip_count(base.width, base.height);
+    slot.array =
+        find_array(base.width, base.height, img.format(), levels, false);
+    slot.layer = arrays[slot.array].array->add_layer();
+    slot.levels = std::min(available, levels);
+    return slot;
+  }
+
+  slot.array =
+      find_array(ATLAS_SIZE, ATLAS_SIZE, img.format(), ATLAS_LEVELS, true);
+  auto &entry = arrays[slot.array];
+
+  // at least one texel of gutter on the smallest kept level keeps bilinear
+  // taps off the neighbours
+  constexpr int GUTTER = 1 << (ATLAS_LEVELS - 1);
+  const auto align = [](const int v) {
+    return (v + ATLAS_ALIGN - 1) / ATLAS_ALIGN * ATLAS_ALIGN;
+  };
+  const int w = align(base.width + GUTTER);
+  const int h = align(base.height + GUTTER);
+
+  std::optional<glm::ivec2> position;
+  for (uint32_t page = 0; page < entry.pages.size() && !position; ++page) {
+    position = entry.pages[page].pack(w, h);
+    slot.layer = page;
+  }
+  if (!position) {
+    slot.layer = entry.array->add_layer();
+    position = entry.pages.emplace_back(ATLAS_SIZE, ATLAS_SIZE).pack(w, h);
+  }
+
+  constexpr float scale = 1.0f / ATLAS_SIZE;
+  slot.x = position->x;
+  slot.y = position->y;
+  slot.levels = std::min(available, ATLAS_LEVELS);
+  slot.uv_rect = {slot.x * scale, slot.y * scale, base.width * scale,
+                  base.height * scale};
+  return slot;
+}
+
+auto texture_packer::upload(const packed_texture &slot, const int level,
+                            const int y, int w, int h, const void *pixels,
+                            const std::size_t size) const -> void {
+  const auto &entry = arrays[slot.array];
+  if (entry.atlas && entry.array->get_block() != block_format::NONE) {
+    // inside an atlas the region never touches the layer's edge, so
+    // compressed writes must cover whole blocks
+    w = (w + 3) & ~3;
+    h = (h + 3) & ~3;
+  }
+  entry.array->upload(slot.layer, level, slot.x >> level,
+                      (slot.y >> level) + y, w, h, pixels, size);
+}
+
+auto texture_packer::add(const image &img) -> std::optional<packed_texture> {
+  auto slot = reserve(img);
+  if (!slot)
+    return std::nullopt;
+
+  for (int level = 0; level < slot->levels; ++level) {
+    const auto &l = img.levels[level];
+    upload(*slot, level, 0, l.width, l.height, l.pixels.get(), l.size);
+  }
+  slot->ready = true;
+  return slot;
+}
+
+auto texture_packer::use(const uint32_t array, const uint32_t unit) const
+    -> void {
+  arrays[array].array->use(unit);
+}
+
+auto texture_packer::get_array(const uint32_t array) const
+    -> const texture_array & {
+  return *arrays[array].array;
+}
+
+auto texture_packer::get_array_count() const noexcept -> std::size_t {
+  return arrays.size();
+}
+
+} // namespace derp
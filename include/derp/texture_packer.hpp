@@ -0,0 +1,120 @@
+//===-- Implementation header for texture packer class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+#include "texture_array.hpp"
+
+#include "glm/vec2.hpp"
+#include "glm/vec4.hpp"
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint32_t
+#include <memory>   // std::unique_ptr
+#include <optional> // std::optional
+#include <vector>   // std::vector
+
+namespace derp {
+
+// Where a packed image ended up. Materials keep `array` and `layer` and hand
+// `uv_rect` to the shader (see material_table). The rect is in the layer's
+// storage space, row 0 first, so shaders apply it to the coordinates they
+// sample with, after any flip of v.
+struct packed_texture {
+  uint32_t array = 0; // index of the packer's texture array
+  uint32_t layer = 0;
+  glm::vec4 uv_rect{0.0f, 0.0f, 1.0f, 1.0f}; // offset xy, scale zw
+
+  // texel position of the region in its layer and the levels it has
+  int x = 0;
+  int y = 0;
+  int levels = 0;
+  bool ready = false; // set once the pixels have been uploaded
+};
+
+// Groups textures of the same format into GL_TEXTURE_2D_ARRAYs so a scene
+// can be drawn with a handful of array bindings instead of a bind per
+// material.
+//
+// Large images get a layer of their own in an array of their exact size.
+// Small images are packed into shared atlas layers with a skyline packer.
+// Atlas regions start on a multiple of ATLAS_ALIGN texels so every level they
+// carry stays block aligned, and only their first ATLAS_LEVELS levels are
+// kept. Atlas UVs cannot wrap, shaders have to clamp (or fract()) inside
+// uv_rect before applying it.
+class texture_packer {
+public:
+  static constexpr int ATLAS_SIZE = 2048;
+  static constexpr int ATLAS_MAX_ENTRY = 256; // larger images get layers
+  static constexpr int ATLAS_LEVELS = 4;
+  static constexpr int ATLAS_ALIGN = 4 << (ATLAS_LEVELS - 1);
+
+private:
+  // bottom left skyline bin packer for one atlas layer
+  class skyline {
+  private:
+    struct segment {
+      int x;
+      int y;
+      int width;
+    };
+
+    int width;
+    int height;
+    std::vector<segment> segments;
+
+    [[nodiscard]]
+    auto fit(std::size_t i, int w, int h) const -> std::optional<int>;
+
+  public:
+    skyline(int width, int height);
+
+    // top left corner of a free w x h rectangle, nothing if the layer is full
+    [[nodiscard]]
+    auto pack(int w, int h) -> std::optional<glm::ivec2>;
+  };
+
+  struct array_entry {
+    std::unique_ptr<texture_array> array{};
+    bool atlas = false;
+    std::vector<skyline> pages{}; // one per layer of atlas arrays
+  };
+
+  std::vector<array_entry> arrays;
+
+  auto find_array(int w, int h, const texel_format &f, int l, bool atlas)
+      -> uint32_t;
+
+public:
+  // finds a place for `img` without uploading anything, nothing for images
+  // no array can hold
+  [[nodiscard]]
+  auto reserve(const image &img) -> std::optional<packed_texture>;
+
+  // writes rows [y, y + h) of one level of an image placed by reserve(), y
+  // is a multiple of 4 for compressed arrays. `pixels` is a client pointer
+  // or an offset into the bound GL_PIXEL_UNPACK_BUFFER.
+  auto upload(const packed_texture &slot, int level, int y, int w, int h,
+              const void *pixels, std::size_t size) const -> void;
+
+  // reserve() and upload() straight from client memory
+  [[nodiscard]]
+  auto add(const image &img) -> std::optional<packed_texture>;
+
+  auto use(uint32_t array, uint32_t unit = 0) const -> void;
+
+  [[nodiscard]]
+  auto get_array(uint32_t array) const -> const texture_array &;
+
+  [[nodiscard]]
+  auto get_array_count() const noexcept -> std::size_t;
+}; // class texture_packer
+
+} // namespace derp
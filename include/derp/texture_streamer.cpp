@@ -0,0 +1,586 @@
+//===-- Implementation of texture streamer class --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "texture_streamer.hpp"
+
+#include "channel_pack.hpp"
+#include "hash.hpp"
+#include "ktx2.hpp"
+#include "pixel_convert.hpp"
+
+#include <algorithm> // std::max, std::min, std::ranges::count_if
+#include <array>     // std::array
+#include <cmath>     // std::floor, std::log2, std::tan
+#include <format>    // std::format
+#include <print>     // std::println
+#include <utility>   // std::pair
+#include <variant>   // std::visit, std::get_if
+#include <vector>    // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+// bump whenever the importer's output changes to invalidate old entries
+constexpr uint32_t CACHE_VERSION = 4;
+
+auto has_alpha(const image &img) -> bool {
+  if (img.channels != 2 && img.channels != 4)
+    return false;
+
+  const auto &base = img.levels.front();
+  for (std::size_t i = img.channels - 1; i < base.size; i += img.channels) {
+    if (base.pixels.get()[i] != 255)
+      return true;
+  }
+  return false;
+}
+
+auto choose_block(const texture::texture_type type, const image &img,
+                  const texture_quality quality, const bool s3tc)
+    -> block_format {
+  using enum texture::texture_type;
+  if (img.type != pixel_type::UNORM8)
+    return block_format::NONE; // no BC6H encoder, floats stay half floats
+  if (type == NORMAL)
+    return block_format::BC5; // z is rebuilt in the shader
+  if (type == NORMAL_HEIGHT)
+    return block_format::BC7; // BC5 has no room for the height
+  if (type == HEIGHT)
+    return block_format::BC4;
+  if (quality == texture_quality::HIGH || !s3tc)
+    return block_format::BC7;
+  return has_alpha(img) ? block_format::BC3 : block_format::BC1;
+}
+
+auto canonical_path(const std::string &source) -> std::string {
+  std::error_code ec;
+  auto canonical = std::filesystem::weakly_canonical(source, ec);
+  return ec ? source : canonical.string();
+}
+
+// identifies a source file's contents
+auto source_key(const std::string &source) -> std::string {
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(source, ec);
+  const auto mtime = std::filesystem::last_write_time(source, ec);
+  return std::format("{}|{}|{}", canonical_path(source), size,
+                     mtime.time_since_epoch().count());
+}
+
+// every channel's source, named by `source`, and channel, or its fill
+auto pack_key(const channel_pack &pack,
+              std::string (*source)(const std::string &)) -> std::string {
+  auto key = std::format("pack {}", pack.count);
+  for (int c = 0; c < pack.count; ++c) {
+    const auto &src = pack.channels[c];
+    key += src.path.empty()
+               ? std::format(";fill {}", src.fill)
+               : std::format(";{}#{}", source(src.path), src.channel);
+  }
+  return key;
+}
+
+// the sources of a packed texture, for messages
+auto pack_name(const channel_pack &pack) -> std::string {
+  std::string name;
+  for (int c = 0; c < pack.count; ++c) {
+    const auto &path = pack.channels[c].path;
+    if (!path.empty() && !name.contains(path))
+      name += name.empty() ? path : " + " + path;
+  }
+  return name;
+}
+
+// keyed by the sources and everything that changes what we import
+auto cache_path(const std::filesystem::path &cache_dir,
+                const std::string &sources, const texture::texture_type type,
+                const texture_quality quality, const bool s3tc)
+    -> std::filesystem::path {
+  const auto key =
+      std::format("{}|{}|{}|{}|{}", sources, static_cast<int>(type),
+                  static_cast<int>(quality), s3tc, CACHE_VERSION);
+  return cache_dir / std::format("{:016x}.ktx2", fnv1a(key));
+}
+
+} // namespace
+
+texture_streamer::texture_streamer(std::filesystem::path cache_dir,
+                                   const std::size_t staging_size,
+                                   const uint32_t worker_count,
+                                   const texture_quality quality)
+    : cache_dir(std::move(cache_dir)), scheduler(staging_size),
+      quality(quality), s3tc(GLAD_GL_EXT_texture_compression_s3tc != 0),
+      pool(worker_count) {
+  if (!s3tc)
+    std::println("[INFO] S3TC unsupported, colour textures fall back to BC7");
+}
+
+auto texture_streamer::registry_key(const std::string &source,
+                                    const texture::texture_type type,
+                                    const bool packed) -> std::string {
+  // the streamer's preset is fixed, so the type covers the import settings
+  return std::format("{}|{}|{}", source, static_cast<int>(type), packed);
+}
+
+auto texture_streamer::sweep() -> void {
+  if (registry.size() < sweep_at)
+    return;
+  std::erase_if(registry, [](const auto &e) {
+    return std::visit([](const auto &p) { return p.expired(); }, e.second);
+  });
+  sweep_at = std::max<std::size_t>(64, registry.size() * 2);
+}
+
+auto texture_streamer::load(const std::string &texture_path,
+                            const texture::texture_type type)
+    -> std::shared_ptr<texture> {
+  return acquire(canonical_path(texture_path), {.path = texture_path}, type);
+}
+
+auto texture_streamer::load(const channel_pack &pack,
+                            const texture::texture_type type)
+    -> std::shared_ptr<texture> {
+  // paths, not contents: like files, a changed source shows up next launch
+  return acquire(pack_key(pack, canonical_path),
+                 {.path = pack_name(pack), .pack = pack}, type);
+}
+
+auto texture_streamer::acquire(const std::string &source, decoded job,
+                               const texture::texture_type type)
+    -> std::shared_ptr<texture> {
+  auto &entry = registry[registry_key(source, type, false)];
+  if (auto existing = std::get_if<std::weak_ptr<texture>>(&entry)) {
+    if (auto tex = existing->lock())
+      return tex;
+  }
+
+  auto tex = std::make_shared<texture>(type);
+  entry = std::weak_ptr(tex);
+  residencies.insert_or_assign(tex.get(), residency{.tex = tex});
+  sweep();
+
+  job.target = tex;
+  decode(std::move(job), type);
+  return tex;
+}
+
+auto texture_streamer::load_packed(const std::string &texture_path,
+                                   const texture::texture_type type)
+    -> std::shared_ptr<const packed_texture> {
+  return acquire_packed(canonical_path(texture_path), {.path = texture_path},
+                        type);
+}
+
+auto texture_streamer::load_packed(const channel_pack &pack,
+                                   const texture::texture_type type)
+    -> std::shared_ptr<const packed_texture> {
+  return acquire_packed(pack_key(pack, canonical_path),
+                        {.path = pack_name(pack), .pack = pack}, type);
+}
+
+auto texture_streamer::acquire_packed(const std::string &source, decoded job,
+                                      const texture::texture_type type)
+    -> std::shared_ptr<const packed_texture> {
+  auto &entry = registry[registry_key(source, type, true)];
+  if (auto existing = std::get_if<std::weak_ptr<packed_texture>>(&entry)) {
+    if (auto slot = existing->lock())
+      return slot;
+  }
+
+  auto slot = std::make_shared<packed_texture>();
+  entry = std::weak_ptr(slot);
+  sweep();
+
+  job.packed = slot;
+  decode(std::move(job), type);
+  return slot;
+}
+
+auto texture_streamer::decode(decoded job, const texture::texture_type type)
+    -> void {
+  ++in_flight;
+
+  pool.submit([this, result = std::move(job), type]() mutable {
+    const bool packed = !result.pack.empty();
+    const auto sources = packed ? pack_key(result.pack, source_key)
+                                : source_key(result.path);
+    const auto cached = cache_path(cache_dir, sources, type, quality, s3tc);
+
+    if (auto img = read_ktx2(cached)) {
+      result.img = std::move(*img);
+      result.cache = cached;
+    } else {
+      if (auto img = packed ? pack_channels(result.pack)
+                            : load_image(result.path)) {
+        result.img = std::move(*img);
+        result.img.srgb = texture::is_colour(type) &&
+                          result.img.type == pixel_type::UNORM8;
+        generate_mips(result.img);
+        compress(result.img, choose_block(type, result.img, quality, s3tc),
+                 quality, pool);
+        negotiate_format(result.img, pool);
+        if (write_ktx2(cached, result.img))
+          result.cache = cached;
+      } else {
+        result.error = std::move(img.error());
+      }
+    }
+
+    std::scoped_lock lock(ready_mutex);
+    ready.push_back(std::move(result));
+  });
+}
+
+auto texture_streamer::chain_bytes(const residency &r, const int first)
+    -> std::size_t {
+  std::size_t bytes = 0;
+  for (int level = first; level < r.levels; ++level) {
+    bytes += level_size(std::max(1, r.width >> level),
+                        std::max(1, r.height >> level), r.format.channels,
+                        r.format.block, r.format.type);
+  }
+  return bytes;
+}
+
+auto texture_streamer::floor_level(const residency &r) -> int {
+  int level = 0;
+  while (level + 1 < r.levels &&
+         std::max(r.width >> level, r.height >> level) > MIN_RESIDENT_SIZE)
+    ++level;
+  return level;
+}
+
+auto texture_streamer::wanted_level(const residency &r) -> int {
+  // texels that land on one pixel of the finest level, every level up
+  // halves them
+  const float texels =
+      static_cast<float>(std::max(r.width, r.height)) * r.footprint;
+  const int level =
+      texels > 1.0f ? static_cast<int>(std::floor(std::log2(texels))) : 0;
+  return std::min(level, floor_level(r));
+}
+
+auto texture_streamer::set_view(const float fov_y, const int viewport_height)
+    -> void {
+  pixels_per_unit =
+      static_cast<float>(viewport_height) / (2.0f * std::tan(fov_y / 2.0f));
+}
+
+auto texture_streamer::request_mips(const texture &tex,
+                                    const float uv_density,
+                                    const float distance) -> void {
+  const auto it = residencies.find(&tex);
+  if (it == residencies.end() || pixels_per_unit <= 0.0f)
+    return;
+
+  auto &r = it->second;
+  const float footprint =
+      uv_density * std::max(distance, 0.0f) / pixels_per_unit;
+  r.footprint = r.last_seen == frame ? std::min(r.footprint, footprint)
+                                     : footprint;
+  r.last_seen = frame;
+}
+
+auto texture_streamer::set_vram_budget(const std::size_t bytes) noexcept
+    -> void {
+  vram_budget = bytes;
+}
+
+auto texture_streamer::get_vram_used() const noexcept -> std::size_t {
+  return vram_used;
+}
+
+auto texture_streamer::balance() -> void {
+  std::erase_if(residencies,
+                [](const auto &e) { return e.second.tex.expired(); });
+
+  // reads in flight count as resident already
+  vram_used = 0;
+  std::vector<residency *> managed;
+  for (auto &[_, r] : residencies) {
+    if (r.levels == 0)
+      continue; // not uploaded yet
+    vram_used += chain_bytes(r, r.reading >= 0 ? r.reading : r.resident);
+    if (r.last_seen && !r.cache.empty() && r.levels > 1)
+      managed.push_back(&r);
+  }
+
+  // the longest unseen go first, then visible ones finer than they need
+  std::vector<std::pair<residency *, int>> drops;
+  for (auto *r : managed) {
+    if (r->reading >= 0)
+      continue;
+    const int keep = r->last_seen == frame ? wanted_level(*r) : floor_level(*r);
+    if (keep > r->resident)
+      drops.emplace_back(r, keep);
+  }
+  std::ranges::sort(drops, [&](const auto &a, const auto &b) {
+    const bool a_seen = a.first->last_seen == frame;
+    const bool b_seen = b.first->last_seen == frame;
+    if (a_seen != b_seen)
+      return b_seen;
+    return a.first->last_seen < b.first->last_seen;
+  });
+
+  for (auto &[r, keep] : drops) {
+    if (vram_used <= vram_budget)
+      break;
+    auto tex = r->tex.lock();
+    int first = r->resident;
+    while (first < keep && vram_used > vram_budget) {
+      vram_used -= chain_bytes(*r, first) - chain_bytes(*r, first + 1);
+      ++first;
+    }
+    tex->reallocate(std::max(1, r->width >> first),
+                    std::max(1, r->height >> first), r->levels - first,
+                    r->resident - first);
+    r->resident = first;
+  }
+
+  // visible textures missing levels, most missing first
+  std::vector<std::pair<residency *, int>> grows;
+  for (auto *r : managed) {
+    if (r->reading < 0 && r->last_seen == frame) {
+      const int wanted = wanted_level(*r);
+      if (wanted < r->resident)
+        grows.emplace_back(r, wanted);
+    }
+  }
+  std::ranges::sort(grows, [](const auto &a, const auto &b) {
+    return a.first->resident - a.second > b.first->resident - b.second;
+  });
+
+  for (auto &[r, wanted] : grows) {
+    // as close to the wanted level as the budget allows
+    const auto held = chain_bytes(*r, r->resident);
+    int first = wanted;
+    while (first < r->resident &&
+           vram_used + chain_bytes(*r, first) - held > vram_budget)
+      ++first;
+    if (first == r->resident)
+      continue;
+
+    vram_used += chain_bytes(*r, first) - held;
+    r->reading = first;
+    ++in_flight;
+
+    const auto count = static_cast<uint32_t>(r->resident - first);
+    pool.submit([this, count,
+                 job = decoded{.target = r->tex,
+                               .path = r->cache.string(),
+                               .cache = r->cache,
+                               .first_level = first,
+                               .finer = true}]() mutable {
+      if (auto img =
+              read_ktx2(job.cache, static_cast<uint32_t>(job.first_level),
+                        count))
+        job.img = std::move(*img);
+      else
+        job.error = "couldn't read the cache entry";
+
+      std::scoped_lock lock(ready_mutex);
+      ready.push_back(std::move(job));
+    });
+  }
+}
+
+auto texture_streamer::start_upload(decoded job) -> void {
+  auto target = job.target.lock();
+  auto packed = job.packed.lock();
+
+  residency *r = nullptr;
+  if (target) {
+    const auto it = residencies.find(target.get());
+    if (it != residencies.end())
+      r = &it->second;
+  }
+
+  if ((!target && !packed) || job.img.levels.empty() ||
+      (job.finer && (!r || r->resident <= job.first_level))) {
+    if (target || packed) {
+      std::println("[ERROR] Couldn't load texture {}: {}", job.path,
+                   job.error);
+    }
+    if (r)
+      r->reading = -1;
+    --in_flight;
+    return;
+  }
+
+  // the scheduler reads the levels over several frames
+  const auto img = std::make_shared<const image>(std::move(job.img));
+  const auto format = img->format();
+
+  // img levels [skip, skip + count) go to storage levels [0, count)
+  int skip = 0;
+  auto count = static_cast<int>(img->levels.size());
+  uint32_t storage = 0;
+  std::array<int, 3> size{}; // storage width, height, levels
+
+  if (job.finer) {
+    const int first = job.first_level;
+    count = std::min(count, r->resident - first);
+    size = {std::max(1, r->width >> first), std::max(1, r->height >> first),
+            r->levels - first};
+    storage = texture::create_storage(size[0], size[1], size[2], r->format);
+    // the levels it has already come along, the texture samples them until
+    // the new storage is swapped in
+    target->copy_levels(storage, size[0], size[1], size[2],
+                        r->resident - first);
+  } else if (target) {
+    if (r && r->last_seen && !job.cache.empty()) {
+      // only what was asked for so far
+      residency chain = *r;
+      chain.width = img->levels.front().width;
+      chain.height = img->levels.front().height;
+      chain.levels = count;
+      skip = wanted_level(chain);
+      count -= skip;
+    }
+    // single level entries get their chain from generate_mips()
+    const auto &l = img->levels[skip];
+    size = {l.width, l.height,
+            img->levels.size() == 1 ? mip_count(l.width, l.height) : count};
+    storage = texture::create_storage(size[0], size[1], size[2], format);
+  } else if (auto slot = packer.reserve(*img)) {
+    *packed = *slot;
+    count = slot->levels;
+  } else {
+    std::println("[ERROR] Couldn't pack texture {}", job.path);
+    --in_flight;
+    return;
+  }
+
+  for (int level = 0; level < count; ++level) {
+    const auto &l = img->levels[skip + level];
+    // compressed levels go a row of blocks at a time
+    const int unit = format.block == block_format::NONE ? 1 : 4;
+    const int rows = (l.height + unit - 1) / unit;
+    const auto row_bytes = l.size / static_cast<std::size_t>(rows);
+
+    auto write = [this, storage, format, level, unit, width = l.width,
+                  height = l.height,
+                  slot = packed ? *packed : packed_texture{}](
+                     const int first, const int n, const void *pixels,
+                     const std::size_t bytes) {
+      const int y = first * unit;
+      const int h = std::min(n * unit, height - y);
+      if (storage)
+        texture::write_rows(storage, format, level, width, y, h, pixels,
+                            bytes);
+      else
+        packer.upload(slot, level, y, width, h, pixels, bytes);
+    };
+    scheduler.upload_rows(img, l.pixels.get(), row_bytes, rows,
+                          std::move(write));
+  }
+
+  // the chain's level 0 as read, shifting a skipped level back up loses the
+  // odd texels
+  const std::array base{img->levels.front().width,
+                        img->levels.front().height};
+
+  scheduler.then([this, storage, size, skip, base, format,
+                  single = img->levels.size() == 1, target = job.target,
+                  packed = job.packed, finer = job.finer,
+                  first = job.first_level, cache = job.cache] {
+    --in_flight;
+    ++completed;
+
+    if (auto slot = packed.lock()) {
+      slot->ready = true;
+      return;
+    }
+
+    auto tex = target.lock();
+    if (!tex) {
+      glDeleteTextures(1, &storage);
+      return;
+    }
+    tex->adopt(storage, size[0], size[1], size[2],
+               finer ? tex->format : format);
+    if (!finer && single)
+      tex->generate_mips();
+
+    const auto it = residencies.find(tex.get());
+    if (it == residencies.end())
+      return;
+    auto &r = it->second;
+    if (finer) {
+      r.resident = first;
+      r.reading = -1;
+    } else {
+      r.cache = cache;
+      r.width = base[0];
+      r.height = base[1];
+      r.levels = size[2] + skip;
+      r.format = format;
+      r.resident = skip;
+    }
+  });
+}
+
+auto texture_streamer::update(const std::chrono::microseconds budget)
+    -> uint32_t {
+  const auto start = std::chrono::steady_clock::now();
+
+  {
+    std::scoped_lock lock(ready_mutex);
+    for (auto &image : ready) {
+      uploads.push_back(std::move(image));
+    }
+    ready.clear();
+  }
+
+  // storage is made when an upload starts, so only queue about a frame's
+  // worth ahead of the scheduler
+  while (!uploads.empty() &&
+         (!upload_bytes || scheduler.backlog() < upload_bytes)) {
+    start_upload(std::move(uploads.front()));
+    uploads.pop_front();
+  }
+
+  const auto before = completed;
+  const auto spent = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  scheduler.submit(
+      {.bytes = upload_bytes,
+       .time = std::max(budget - spent, std::chrono::microseconds(1))});
+
+  balance();
+  ++frame;
+
+  return completed - before;
+}
+
+auto texture_streamer::set_upload_bytes(const std::size_t bytes) noexcept
+    -> void {
+  upload_bytes = bytes;
+}
+
+auto texture_streamer::loaded() const noexcept -> std::size_t {
+  return static_cast<std::size_t>(
+      std::ranges::count_if(registry, [](const auto &e) {
+        return std::visit([](const auto &p) { return !p.expired(); },
+                          e.second);
+      }));
+}
+
+auto texture_streamer::get_packer() const noexcept -> const texture_packer & {
+  return packer;
+}
+
+auto texture_streamer::pending() const noexcept -> std::size_t {
+  return in_flight;
+}
+
+} // namespace derp
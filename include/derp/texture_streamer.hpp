@@ -0,0 +1,244 @@
+//===-- Implementation header for texture streamer class ------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "bc.hpp"
+#include "channel_pack.hpp"
+#include "image.hpp"
+#include "texture.hpp"
+#include "texture_packer.hpp"
+#include "thread_pool.hpp"
+#include "upload_scheduler.hpp"
+
+#include <chrono>        // std::chrono::microseconds
+#include <cstddef>       // std::size_t
+#include <deque>         // std::deque
+#include <filesystem>    // std::filesystem::path
+#include <memory>        // std::shared_ptr, std::weak_ptr
+#include <mutex>         // std::mutex
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <variant>       // std::variant
+#include <vector>        // std::vector
+
+namespace derp {
+
+// Loads textures without blocking the render thread.
+//
+// load() hands out a texture that samples as a placeholder right away and
+// queues the decode on a worker thread. The worker also builds the mip chain,
+// block compresses it (BC7 or BC1/BC3 for colour and ORM, BC5 for normal
+// maps, BC4 for height maps, BC7 for normal maps with height, .hdr images
+// become half floats, see negotiate_format()) and keeps the result in a KTX2
+// file under the cache directory, so the next launch skips the decode, the
+// filtering and the encode. update(), called once per frame on the render
+// thread, hands finished images to an upload_scheduler, which streams them
+// in row bands until the frame's time or byte budget is spent, so even a 4k
+// texture never lands in one frame. A texture switches to its new storage
+// once the GPU has all of it.
+//
+// Textures are shared: loading a file that is already loaded, or still
+// decoding, with the same import settings returns the same handle and never
+// decodes twice. The GL texture goes away with the last handle.
+// load_packed() places the image in one of the streamer's texture arrays
+// instead, see texture_packer.
+//
+// Textures that get request_mips() calls only keep the levels the screen
+// needs. The finest level is estimated from the distance and the mesh's UV
+// density; finer levels are read back from the cache entry when the camera
+// comes closer, and the finest levels of textures that went unseen are
+// dropped once the VRAM budget is exceeded. Textures never requested keep
+// their whole chain.
+class texture_streamer {
+public:
+  static constexpr std::size_t DEFAULT_STAGING_SIZE =
+      upload_scheduler::DEFAULT_STAGING_SIZE;
+  static constexpr std::size_t DEFAULT_UPLOAD_BYTES = 8 * 1024 * 1024;
+  static constexpr std::size_t DEFAULT_VRAM_BUDGET = 512 * 1024 * 1024;
+  // levels up to this size always stay resident
+  static constexpr int MIN_RESIDENT_SIZE = 64;
+
+  // set DERP_FAST_TEXTURE_IMPORT in CMake to trade quality for import time
+#ifdef DERP_FAST_TEXTURE_IMPORT
+  static constexpr texture_quality DEFAULT_QUALITY = texture_quality::FAST;
+#else
+  static constexpr texture_quality DEFAULT_QUALITY = texture_quality::HIGH;
+#endif
+
+private:
+  struct decoded {
+    std::weak_ptr<texture> target{};
+    std::weak_ptr<packed_texture> packed{}; // set instead of target if packed
+    std::string path{};
+    channel_pack pack{}; // sources of a packed texture, empty for a file
+    image img{};
+    std::string error{};
+    std::filesystem::path cache{}; // empty if the cache entry wasn't kept
+    int first_level = 0;           // chain level of img.levels[0]
+    bool finer = false;            // finer levels for a resident texture
+  };
+
+  // mip residency of a texture handed out by load()
+  struct residency {
+    std::weak_ptr<texture> tex{};
+    std::filesystem::path cache{};
+    int width = 0; // full chain, 0 until the first upload
+    int height = 0;
+    int levels = 0;
+    texel_format format{};
+    int resident = 0;       // first chain level with storage
+    int reading = -1;       // first level of a read in flight, -1 if none
+    float footprint = 0.0f; // UV units per pixel, smallest this frame
+    uint64_t last_seen = 0; // 0 for textures that are never requested
+  };
+
+  std::filesystem::path cache_dir;
+  upload_scheduler scheduler;
+  std::size_t upload_bytes = DEFAULT_UPLOAD_BYTES;
+  texture_quality quality;
+  bool s3tc; // BC1/BC3 need EXT_texture_compression_s3tc, BC7 is core
+
+  std::mutex ready_mutex;
+  std::vector<decoded> ready; // filled by the workers
+
+  // render thread only
+  std::deque<decoded> uploads; // decoded, not handed to the scheduler yet
+  std::size_t in_flight = 0;
+  uint32_t completed = 0; // uploads the GPU has finished, ever
+
+  // canonical path and import settings to the live texture, expired entries
+  // are swept as the map grows
+  std::unordered_map<std::string, std::variant<std::weak_ptr<texture>,
+                                               std::weak_ptr<packed_texture>>>
+      registry;
+  std::size_t sweep_at = 64;
+
+  // packed regions live as long as the packer, only the handles are shared
+  texture_packer packer;
+
+  std::unordered_map<const texture *, residency> residencies;
+  std::size_t vram_budget = DEFAULT_VRAM_BUDGET;
+  std::size_t vram_used = 0;
+  float pixels_per_unit = 0.0f; // screen pixels per unit at distance 1
+  uint64_t frame = 1;
+
+  // declared last so the workers are joined before anything they touch dies
+  thread_pool pool;
+
+  // `source` is a canonical path or a channel pack's key
+  static auto registry_key(const std::string &source,
+                           texture::texture_type type, bool packed)
+      -> std::string;
+  auto sweep() -> void;
+
+  // shared part of both load() overloads, `job` is queued unless `source`
+  // is loaded already
+  auto acquire(const std::string &source, decoded job,
+               texture::texture_type type) -> std::shared_ptr<texture>;
+
+  // the same for both load_packed() overloads
+  auto acquire_packed(const std::string &source, decoded job,
+                      texture::texture_type type)
+      -> std::shared_ptr<const packed_texture>;
+
+  // queues the decode of job.path, the result goes to job's target
+  auto decode(decoded job, texture::texture_type type) -> void;
+
+  // bytes of chain levels [first, r.levels)
+  [[nodiscard]]
+  static auto chain_bytes(const residency &r, int first) -> std::size_t;
+
+  // coarsest first level, the levels from there on never leave
+  [[nodiscard]]
+  static auto floor_level(const residency &r) -> int;
+
+  // finest level the last requests need
+  [[nodiscard]]
+  static auto wanted_level(const residency &r) -> int;
+
+  // drops finest levels until the budget holds, then queues reads of the
+  // levels visible textures are missing
+  auto balance() -> void;
+
+  // makes the job's storage and queues its levels on the scheduler. the
+  // texture keeps sampling what it had until the GPU has every level, then
+  // the new storage is swapped in.
+  auto start_upload(decoded job) -> void;
+
+public:
+  explicit texture_streamer(
+      std::filesystem::path cache_dir = DERP_CACHE_PATH,
+      std::size_t staging_size = DEFAULT_STAGING_SIZE,
+      uint32_t worker_count = 0, texture_quality quality = DEFAULT_QUALITY);
+
+  texture_streamer(const texture_streamer &) = delete;
+  texture_streamer &operator=(const texture_streamer &) = delete;
+
+  [[nodiscard]]
+  auto load(const std::string &texture_path,
+            texture::texture_type type = texture::texture_type::DIFFUSE)
+      -> std::shared_ptr<texture>;
+
+  // like load(), but the texture is packed from the channels of several
+  // images (see channel_pack) on the worker. the packed result is cached
+  // like any other import.
+  [[nodiscard]]
+  auto load(const channel_pack &pack, texture::texture_type type)
+      -> std::shared_ptr<texture>;
+
+  // like load(), but the image lands in a layer or atlas region of the
+  // streamer's texture arrays. the slot is filled in, and `ready` set, once
+  // the upload happened.
+  [[nodiscard]]
+  auto load_packed(const std::string &texture_path,
+                   texture::texture_type type = texture::texture_type::DIFFUSE)
+      -> std::shared_ptr<const packed_texture>;
+
+  // load_packed() of a texture packed from several images, see channel_pack
+  [[nodiscard]]
+  auto load_packed(const channel_pack &pack, texture::texture_type type)
+      -> std::shared_ptr<const packed_texture>;
+
+  // arrays holding the packed textures, bind them with use()
+  [[nodiscard]]
+  auto get_packer() const noexcept -> const texture_packer &;
+
+  // textures with at least one live handle
+  [[nodiscard]]
+  auto loaded() const noexcept -> std::size_t;
+
+  // camera the mip requests are measured with
+  auto set_view(float fov_y, int viewport_height) -> void;
+
+  // `tex` is drawn this frame on a mesh with `uv_density` (see
+  // mesh::get_uv_density()) whose closest point is `distance` units away
+  auto request_mips(const texture &tex, float uv_density, float distance)
+      -> void;
+
+  auto set_vram_budget(std::size_t bytes) noexcept -> void;
+
+  // storage of the textures load() handed out, packed ones not included
+  [[nodiscard]]
+  auto get_vram_used() const noexcept -> std::size_t;
+
+  // uploads finished decodes and balances mip residency, returns how many
+  // textures became ready or got finer levels. uploads stop at `budget` or
+  // the per frame byte budget, whichever comes first.
+  auto update(std::chrono::microseconds budget) -> uint32_t;
+
+  // bytes handed to GL per update(), 0 for no limit
+  auto set_upload_bytes(std::size_t bytes) noexcept -> void;
+
+  // decodes still queued or waiting to be uploaded
+  [[nodiscard]]
+  auto pending() const noexcept -> std::size_t;
+}; // class texture_streamer
+
+} // namespace derp
@@ -0,0 +1,97 @@
+//===-- Implementation of thread pool class -------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "thread_pool.hpp"
+
+#include <algorithm> // std::max, std::min
+#include <atomic>    // std::atomic
+#include <memory>    // std::make_shared
+
+namespace derp {
+
+thread_pool::thread_pool(uint32_t worker_count) {
+  if (worker_count == 0) {
+    const uint32_t hardware = std::thread::hardware_concurrency();
+    worker_count = std::max(1u, hardware > 0 ? hardware - 1 : 1u);
+  }
+
+  workers.reserve(worker_count);
+  for (uint32_t i = 0; i < worker_count; ++i) {
+    workers.emplace_back([this](std::stop_token stop) { work(stop); });
+  }
+}
+
+thread_pool::~thread_pool() {
+  for (auto &worker : workers) {
+    worker.request_stop();
+  }
+  cv.notify_all();
+  // jthread joins on destruction
+}
+
+auto thread_pool::submit(job j) -> void {
+  {
+    std::scoped_lock lock(mutex);
+    jobs.push_back(std::move(j));
+  }
+  cv.notify_one();
+}
+
+auto thread_pool::parallel_for(const uint32_t count,
+                               const std::function<void(uint32_t)> &fn)
+    -> void {
+  struct progress {
+    std::atomic<uint32_t> next{0};
+    std::atomic<uint32_t> done{0};
+  };
+  const auto state = std::make_shared<progress>();
+
+  // helpers that start after the work ran out never touch fn
+  auto run = [state, count, &fn] {
+    for (uint32_t i; (i = state->next++) < count;) {
+      fn(i);
+      if (++state->done == count)
+        state->done.notify_all();
+    }
+  };
+
+  const uint32_t helpers = std::min(size(), count) - (count > 0 ? 1 : 0);
+  for (uint32_t i = 0; i < helpers; ++i) {
+    submit(run);
+  }
+  run();
+
+  for (uint32_t done; (done = state->done.load()) != count;) {
+    state->done.wait(done);
+  }
+}
+
+auto thread_pool::size() const noexcept -> uint32_t {
+  return static_cast<uint32_t>(workers.size());
+}
+
+auto thread_pool::work(std::stop_token stop) -> void {
+  while (true) {
+    job j;
+    {
+      std::unique_lock lock(mutex);
+      if (!cv.wait(lock, stop, [this] { return !jobs.empty(); }))
+        return; // stop requested
+      // the wait also returns true on stop while jobs are left, so check
+      // again rather than draining the queue
+      if (stop.stop_requested())
+        return;
+      j = std::move(jobs.front());
+      jobs.pop_front();
+    }
+    j();
+  }
+}
+
+} // namespace derp
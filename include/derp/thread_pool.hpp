@@ -0,0 +1,60 @@
+//===-- Implementation header for thread pool class -----------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable> // std::condition_variable_any
+#include <cstdint>            // uint32_t
+#include <deque>              // std::deque
+#include <functional>         // std::move_only_function
+#include <mutex>              // std::mutex
+#include <thread>             // std::jthread
+#include <vector>             // std::vector
+
+namespace derp {
+
+// Fixed size pool of worker threads for CPU side asset work (decoding,
+// encoding, conversion). Jobs must not touch GL, the context lives on the
+// render thread only.
+class thread_pool {
+public:
+  using job = std::move_only_function<void()>;
+
+private:
+  std::mutex mutex;
+  std::condition_variable_any cv;
+  std::deque<job> jobs;
+  std::vector<std::jthread> workers;
+
+  auto work(std::stop_token stop) -> void;
+
+public:
+  // 0 picks one worker less than the hardware concurrency, leaving the
+  // render thread a core of its own
+  explicit thread_pool(uint32_t worker_count = 0);
+  // waits only for the jobs already running, queued ones are dropped
+  ~thread_pool();
+
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  auto submit(job j) -> void;
+
+  // runs fn(0) .. fn(count - 1) across the workers and the calling thread,
+  // returns once all of them finished. safe to call from inside a job: the
+  // caller keeps working instead of just waiting, so it cannot deadlock on a
+  // saturated pool.
+  auto parallel_for(uint32_t count, const std::function<void(uint32_t)> &fn)
+      -> void;
+
+  [[nodiscard]]
+  auto size() const noexcept -> uint32_t;
+}; // class thread_pool
+
+} // namespace derp
@@ -0,0 +1,58 @@
+//===-- Implementation of typed buffer classes ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "typed_buffer.hpp"
+#include "memory_barriers.hpp"
+
+#include <cassert> // assert
+
+namespace derp {
+
+auto glsl_members(const std::span<const block_field> fields) -> std::string {
+  std::string members;
+  for (const auto &f : fields) {
+    members += f.count > 1
+                   ? std::format("    {} {}[{}];\n", f.type, f.name, f.count)
+                   : std::format("    {} {};\n", f.type, f.name);
+  }
+  return members;
+}
+
+gpu_buffer::gpu_buffer(const std::size_t size) : size(size) {
+  glCreateBuffers(1, &id);
+  glNamedBufferStorage(id, static_cast<GLsizeiptr>(size), nullptr,
+                       GL_DYNAMIC_STORAGE_BIT);
+}
+
+gpu_buffer::~gpu_buffer() {
+  if (id) {
+    memory_barriers::shared().forget(gpu_resource::BUFFER, id);
+    glDeleteBuffers(1, &id);
+  }
+}
+
+auto gpu_buffer::write(const void *data, const std::size_t bytes,
+                       const std::size_t offset) -> void {
+  assert(offset + bytes <= size);
+  // not before shader writes to it land
+  auto &barriers = memory_barriers::shared();
+  barriers.need(gpu_resource::BUFFER, id, GL_BUFFER_UPDATE_BARRIER_BIT);
+  barriers.flush();
+  glNamedBufferSubData(id, static_cast<GLintptr>(offset),
+                       static_cast<GLsizeiptr>(bytes), data);
+}
+
+auto gpu_buffer::bind(const uint32_t target, const uint32_t index) const
+    -> void {
+  glBindBufferBase(target, index, id);
+}
+
+auto gpu_buffer::get_id() const noexcept -> uint32_t { return id; }
+
+} // namespace derp
@@ -0,0 +1,237 @@
+//===-- Implementation header for typed buffer classes --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>   // std::max
+#include <cstddef>     // std::size_t, offsetof
+#include <cstdint>     // int32_t, uint32_t
+#include <cstring>     // std::memcpy
+#include <format>      // std::format
+#include <span>        // std::span
+#include <string>      // std::string
+#include <string_view> // std::string_view
+#include <type_traits> // std::remove_all_extents_t, std::extent_v
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+namespace derp {
+
+enum class block_layout { STD140, STD430 };
+
+// one member of a block: its GLSL type and name, where the C++ struct puts it
+// and what GLSL needs of it
+struct block_field {
+  std::string_view type;
+  std::string_view name;
+  std::size_t offset;
+  std::size_t size;  // of one element
+  std::size_t align; // base alignment of one element
+  std::size_t count; // array length, 1 for plain members
+};
+
+// GLSL type name, size and base alignment of T. No mat3: GLSL pads its
+// columns to vec4 and glm::mat3 doesn't
+template <typename T> struct glsl_type;
+
+#define DERP_GLSL_TYPE(T, NAME, SIZE, ALIGN)                                   \
+  template <> struct glsl_type<T> {                                            \
+    static constexpr std::string_view name = NAME;                             \
+    static constexpr std::size_t size = SIZE;                                  \
+    static constexpr std::size_t align = ALIGN;                                \
+  }
+
+DERP_GLSL_TYPE(float, "float", 4, 4);
+DERP_GLSL_TYPE(int32_t, "int", 4, 4);
+DERP_GLSL_TYPE(uint32_t, "uint", 4, 4);
+DERP_GLSL_TYPE(glm::vec2, "vec2", 8, 8);
+DERP_GLSL_TYPE(glm::vec3, "vec3", 12, 16);
+DERP_GLSL_TYPE(glm::vec4, "vec4", 16, 16);
+DERP_GLSL_TYPE(glm::ivec4, "ivec4", 16, 16);
+DERP_GLSL_TYPE(glm::uvec4, "uvec4", 16, 16);
+DERP_GLSL_TYPE(glm::mat4, "mat4", 64, 16);
+
+#undef DERP_GLSL_TYPE
+
+template <typename M>
+consteval auto make_field(const std::string_view name,
+                          const std::size_t offset) -> block_field {
+  using element = std::remove_all_extents_t<M>;
+  static_assert(sizeof(element) == glsl_type<element>::size,
+                "C++ and GLSL disagree on the size of this type");
+  return {.type = glsl_type<element>::name,
+          .name = name,
+          .offset = offset,
+          .size = glsl_type<element>::size,
+          .align = glsl_type<element>::align,
+          .count = std::max<std::size_t>(std::extent_v<M>, 1)};
+}
+
+// a member of a block struct, the GLSL name is the C++ one
+#define DERP_BLOCK_FIELD(T, MEMBER)                                            \
+  ::derp::make_field<decltype(T::MEMBER)>(#MEMBER, offsetof(T, MEMBER))
+
+// Specialise for every struct shared with shaders:
+//
+//   template <> struct derp::block_traits<frame_data> {
+//     static constexpr std::string_view name = "frame_data"; // GLSL type
+//     static constexpr std::string_view instance = "frame";  // GLSL variable
+//     static constexpr uint32_t binding = 0;
+//     static constexpr std::array fields{
+//         DERP_BLOCK_FIELD(frame_data, view), ...};
+//   };
+//
+// fields in declaration order, padding members included.
+template <typename T> struct block_traits;
+
+[[nodiscard]]
+constexpr auto round_up(const std::size_t n, const std::size_t align)
+    -> std::size_t {
+  return (n + align - 1) / align * align;
+}
+
+// true if every field of T sits where `layout` puts it and sizeof(T) is the
+// block's size. where it fails, add explicit padding members
+template <typename T>
+[[nodiscard]]
+consteval auto follows(const block_layout layout) -> bool {
+  const bool std140 = layout == block_layout::STD140;
+  std::size_t offset = 0;
+  std::size_t struct_align = std140 ? 16 : 1;
+  for (const auto &f : block_traits<T>::fields) {
+    // std140 rounds array elements up to vec4
+    const auto align =
+        f.count > 1 && std140 ? round_up(f.align, 16) : f.align;
+    offset = round_up(offset, align);
+    if (f.offset != offset)
+      return false;
+    offset += f.count > 1 ? round_up(f.size, align) * f.count : f.size;
+    struct_align = std::max(struct_align, align);
+  }
+  return round_up(offset, struct_align) == sizeof(T);
+}
+
+// the members of a block or struct declaration, one per line
+[[nodiscard]]
+auto glsl_members(std::span<const block_field> fields) -> std::string;
+
+// A GL buffer object written whole or in ranges, bound by index.
+class gpu_buffer {
+protected:
+  uint32_t id = 0;
+  std::size_t size = 0;
+
+  explicit gpu_buffer(std::size_t size);
+
+  auto write(const void *data, std::size_t bytes, std::size_t offset) -> void;
+  auto bind(uint32_t target, uint32_t index) const -> void;
+
+public:
+  ~gpu_buffer();
+
+  gpu_buffer(const gpu_buffer &) = delete;
+  gpu_buffer &operator=(const gpu_buffer &) = delete;
+
+  [[nodiscard]]
+  auto get_id() const noexcept -> uint32_t;
+}; // class gpu_buffer
+
+// One std140 uniform block holding a T. The block's binding is part of the
+// generated declaration, so any shader that includes it reads the same
+// buffer without glUniformBlockBinding.
+template <typename T> class uniform_buffer : public gpu_buffer {
+  static_assert(follows<T>(block_layout::STD140),
+                "the struct doesn't match std140, add padding members");
+
+  T shadow{}; // what the buffer holds
+
+public:
+  uniform_buffer() : gpu_buffer(sizeof(T)) {
+    gpu_buffer::write(&shadow, sizeof(T), 0);
+  }
+
+  // one glNamedBufferSubData from the first to the last byte that changed,
+  // none if nothing did. members that stay put, a static projection, cost
+  // nothing unless they sit between ones that change
+  auto write(const T &value) -> void {
+    const auto *from = reinterpret_cast<const unsigned char *>(&value);
+    auto *to = reinterpret_cast<unsigned char *>(&shadow);
+    std::size_t first = 0;
+    while (first < sizeof(T) && from[first] == to[first])
+      ++first;
+    if (first == sizeof(T))
+      return;
+    std::size_t last = sizeof(T);
+    while (from[last - 1] == to[last - 1])
+      --last;
+    std::memcpy(to + first, from + first, last - first);
+    gpu_buffer::write(to + first, last - first, first);
+  }
+
+  auto bind() const -> void {
+    gpu_buffer::bind(GL_UNIFORM_BUFFER, block_traits<T>::binding);
+  }
+
+  // layout(std140, binding = N) uniform name_block { ... } instance;
+  [[nodiscard]]
+  static auto glsl() -> std::string {
+    using traits = block_traits<T>;
+    return std::format(
+        "layout(std140, binding = {}) uniform {}_block {{\n{}}} {};\n",
+        traits::binding, traits::name, glsl_members(traits::fields),
+        traits::instance);
+  }
+}; // class uniform_buffer
+
+// An std430 shader storage block holding an array of T, one element per
+// object. Shaders index it, with gl_BaseInstance for instance.
+template <typename T> class storage_buffer : public gpu_buffer {
+  static_assert(follows<T>(block_layout::STD430),
+                "the struct doesn't match std430, add padding members");
+
+  std::size_t capacity;
+
+public:
+  explicit storage_buffer(const std::size_t capacity)
+      : gpu_buffer(sizeof(T) * capacity), capacity(capacity) {}
+
+  // one glNamedBufferSubData for elements [first, first + values.size())
+  auto write(const std::span<const T> values, const std::size_t first = 0)
+      -> void {
+    gpu_buffer::write(values.data(), values.size_bytes(), first * sizeof(T));
+  }
+
+  auto bind() const -> void {
+    gpu_buffer::bind(GL_SHADER_STORAGE_BUFFER, block_traits<T>::binding);
+  }
+
+  [[nodiscard]]
+  auto get_capacity() const noexcept -> std::size_t {
+    return capacity;
+  }
+
+  // struct name { ... };
+  // layout(std430, binding = N) readonly buffer name_block {
+  //   name instance[];
+  // };
+  // without readonly for shaders that write it
+  [[nodiscard]]
+  static auto glsl(const bool writable = false) -> std::string {
+    using traits = block_traits<T>;
+    return std::format("struct {} {{\n{}}};\nlayout(std430, binding = {}) "
+                       "{}buffer {}_block {{\n    {} {}[];\n}};\n",
+                       traits::name, glsl_members(traits::fields),
+                       traits::binding, writable ? "" : "readonly ",
+                       traits::name, traits::name, traits::instance);
+  }
+}; // class storage_buffer
+
+} // namespace derp
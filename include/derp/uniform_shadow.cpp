@@ -0,0 +1,303 @@
+//===-- Implementation of uniform shadow class ----------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "uniform_shadow.hpp"
+
+#include <algorithm> // std::max
+#include <bit>       // std::countr_zero
+#include <format>    // std::format
+#include <stdexcept> // std::runtime_error
+#include <vector>    // std::erase
+
+#include <glad/glad.h>
+
+namespace derp {
+
+namespace {
+
+// shadows with dirty uniforms, render thread only
+auto pending() -> std::vector<uniform_shadow *> & {
+  static std::vector<uniform_shadow *> shadows;
+  return shadows;
+}
+
+enum class component { FLOAT, DOUBLE, INT, UINT };
+
+// what one element of a uniform of GL type `type` is made of
+struct element {
+  component kind;
+  uint32_t components; // matrices count every entry
+};
+
+auto element_of(const uint32_t type) -> element {
+  switch (type) {
+  case GL_FLOAT:
+    return {component::FLOAT, 1};
+  case GL_FLOAT_VEC2:
+    return {component::FLOAT, 2};
+  case GL_FLOAT_VEC3:
+    return {component::FLOAT, 3};
+  case GL_FLOAT_VEC4:
+  case GL_FLOAT_MAT2:
+    return {component::FLOAT, 4};
+  case GL_FLOAT_MAT2x3:
+  case GL_FLOAT_MAT3x2:
+    return {component::FLOAT, 6};
+  case GL_FLOAT_MAT2x4:
+  case GL_FLOAT_MAT4x2:
+    return {component::FLOAT, 8};
+  case GL_FLOAT_MAT3:
+    return {component::FLOAT, 9};
+  case GL_FLOAT_MAT3x4:
+  case GL_FLOAT_MAT4x3:
+    return {component::FLOAT, 12};
+  case GL_FLOAT_MAT4:
+    return {component::FLOAT, 16};
+  case GL_DOUBLE:
+    return {component::DOUBLE, 1};
+  case GL_DOUBLE_VEC2:
+    return {component::DOUBLE, 2};
+  case GL_DOUBLE_VEC3:
+    return {component::DOUBLE, 3};
+  case GL_DOUBLE_VEC4:
+  case GL_DOUBLE_MAT2:
+    return {component::DOUBLE, 4};
+  case GL_DOUBLE_MAT2x3:
+  case GL_DOUBLE_MAT3x2:
+    return {component::DOUBLE, 6};
+  case GL_DOUBLE_MAT2x4:
+  case GL_DOUBLE_MAT4x2:
+    return {component::DOUBLE, 8};
+  case GL_DOUBLE_MAT3:
+    return {component::DOUBLE, 9};
+  case GL_DOUBLE_MAT3x4:
+  case GL_DOUBLE_MAT4x3:
+    return {component::DOUBLE, 12};
+  case GL_DOUBLE_MAT4:
+    return {component::DOUBLE, 16};
+  case GL_UNSIGNED_INT:
+    return {component::UINT, 1};
+  case GL_UNSIGNED_INT_VEC2:
+    return {component::UINT, 2};
+  case GL_UNSIGNED_INT_VEC3:
+    return {component::UINT, 3};
+  case GL_UNSIGNED_INT_VEC4:
+    return {component::UINT, 4};
+  case GL_INT_VEC2:
+  case GL_BOOL_VEC2:
+    return {component::INT, 2};
+  case GL_INT_VEC3:
+  case GL_BOOL_VEC3:
+    return {component::INT, 3};
+  case GL_INT_VEC4:
+  case GL_BOOL_VEC4:
+    return {component::INT, 4};
+  default: // int, bool, samplers, images
+    return {component::INT, 1};
+  }
+}
+
+auto element_size(const element e) -> uint32_t {
+  return e.components * (e.kind == component::DOUBLE ? 8 : 4);
+}
+
+// the glProgramUniformMatrix*v call of a matrix type, nullptr for the rest
+auto matrix_call(const uint32_t type) -> PFNGLPROGRAMUNIFORMMATRIX2FVPROC {
+  switch (type) {
+  case GL_FLOAT_MAT2:
+    return glProgramUniformMatrix2fv;
+  case GL_FLOAT_MAT3:
+    return glProgramUniformMatrix3fv;
+  case GL_FLOAT_MAT4:
+    return glProgramUniformMatrix4fv;
+  case GL_FLOAT_MAT2x3:
+    return glProgramUniformMatrix2x3fv;
+  case GL_FLOAT_MAT2x4:
+    return glProgramUniformMatrix2x4fv;
+  case GL_FLOAT_MAT3x2:
+    return glProgramUniformMatrix3x2fv;
+  case GL_FLOAT_MAT3x4:
+    return glProgramUniformMatrix3x4fv;
+  case GL_FLOAT_MAT4x2:
+    return glProgramUniformMatrix4x2fv;
+  case GL_FLOAT_MAT4x3:
+    return glProgramUniformMatrix4x3fv;
+  default:
+    return nullptr;
+  }
+}
+
+auto matrix_call_d(const uint32_t type) -> PFNGLPROGRAMUNIFORMMATRIX2DVPROC {
+  switch (type) {
+  case GL_DOUBLE_MAT2:
+    return glProgramUniformMatrix2dv;
+  case GL_DOUBLE_MAT3:
+    return glProgramUniformMatrix3dv;
+  case GL_DOUBLE_MAT4:
+    return glProgramUniformMatrix4dv;
+  case GL_DOUBLE_MAT2x3:
+    return glProgramUniformMatrix2x3dv;
+  case GL_DOUBLE_MAT2x4:
+    return glProgramUniformMatrix2x4dv;
+  case GL_DOUBLE_MAT3x2:
+    return glProgramUniformMatrix3x2dv;
+  case GL_DOUBLE_MAT3x4:
+    return glProgramUniformMatrix3x4dv;
+  case GL_DOUBLE_MAT4x2:
+    return glProgramUniformMatrix4x2dv;
+  case GL_DOUBLE_MAT4x3:
+    return glProgramUniformMatrix4x3dv;
+  default:
+    return nullptr;
+  }
+}
+
+// uploads `count` elements of GL type `type` from `copy`
+auto upload(const uint32_t program, const int location, const uint32_t type,
+            const int count, const std::byte *copy) -> void {
+  const auto [kind, components] = element_of(type);
+  const auto *f = reinterpret_cast<const float *>(copy);
+  const auto *d = reinterpret_cast<const double *>(copy);
+  const auto *u = reinterpret_cast<const uint32_t *>(copy);
+  const auto *i = reinterpret_cast<const int *>(copy);
+
+  if (const auto matrix = matrix_call(type)) {
+    matrix(program, location, count, GL_FALSE, f);
+    return;
+  }
+  if (const auto matrix = matrix_call_d(type)) {
+    matrix(program, location, count, GL_FALSE, d);
+    return;
+  }
+
+  // what is left are scalars and vectors
+  switch (kind) {
+  case component::FLOAT:
+    (components == 1   ? glProgramUniform1fv
+     : components == 2 ? glProgramUniform2fv
+     : components == 3 ? glProgramUniform3fv
+                       : glProgramUniform4fv)(program, location, count, f);
+    break;
+  case component::DOUBLE:
+    (components == 1   ? glProgramUniform1dv
+     : components == 2 ? glProgramUniform2dv
+     : components == 3 ? glProgramUniform3dv
+                       : glProgramUniform4dv)(program, location, count, d);
+    break;
+  case component::UINT:
+    (components == 1   ? glProgramUniform1uiv
+     : components == 2 ? glProgramUniform2uiv
+     : components == 3 ? glProgramUniform3uiv
+                       : glProgramUniform4uiv)(program, location, count, u);
+    break;
+  case component::INT: // bools too, and the unit of samplers and images
+    (components == 1   ? glProgramUniform1iv
+     : components == 2 ? glProgramUniform2iv
+     : components == 3 ? glProgramUniform3iv
+                       : glProgramUniform4iv)(program, location, count, i);
+    break;
+  }
+}
+
+} // namespace
+
+uniform_shadow::uniform_shadow(const uint32_t program,
+                               const program_reflection &reflection)
+    : program(program) {
+  const auto uniforms = reflection.get_uniforms();
+  slots.reserve(uniforms.size());
+  uint32_t offset = 0;
+  for (const auto &u : uniforms) {
+    const auto size = element_size(element_of(u.type));
+    const auto count = static_cast<uint32_t>(std::max(u.count, 1));
+    slots.push_back({.location = u.location,
+                     .type = u.type,
+                     .offset = offset,
+                     .size = size,
+                     .count = count});
+    offset += size * count;
+  }
+  values.resize(offset);
+  dirty.resize((slots.size() + 63) / 64);
+
+  // what the link left, 0 or the layout(binding) of a sampler. array
+  // elements sit at consecutive locations
+  for (const auto &s : slots) {
+    if (s.location == -1)
+      continue;
+    const auto kind = element_of(s.type).kind;
+    const auto size = static_cast<int>(s.size);
+    for (uint32_t i = 0; i < s.count; ++i) {
+      const auto location = s.location + static_cast<int>(i);
+      auto *copy = values.data() + s.offset + i * s.size;
+      switch (kind) {
+      case component::FLOAT:
+        glGetnUniformfv(program, location, size,
+                        reinterpret_cast<float *>(copy));
+        break;
+      case component::DOUBLE:
+        glGetnUniformdv(program, location, size,
+                        reinterpret_cast<double *>(copy));
+        break;
+      case component::UINT:
+        glGetnUniformuiv(program, location, size,
+                         reinterpret_cast<uint32_t *>(copy));
+        break;
+      case component::INT:
+        glGetnUniformiv(program, location, size,
+                        reinterpret_cast<int *>(copy));
+        break;
+      }
+    }
+  }
+}
+
+uniform_shadow::~uniform_shadow() {
+  if (queued)
+    std::erase(pending(), this);
+}
+
+auto uniform_shadow::mismatch(const std::size_t index,
+                              const std::size_t bytes) const -> void {
+  const auto &s = slots[index];
+  throw std::runtime_error(
+      std::format("[ERROR] uniform at location {} of shader program {} has "
+                  "GL type {:#x}, a {} byte value doesn't fit",
+                  s.location, program, s.type, bytes));
+}
+
+auto uniform_shadow::mark(const std::size_t index) -> void {
+  dirty[index / 64] |= uint64_t{1} << (index % 64);
+  if (!queued) {
+    pending().push_back(this);
+    queued = true;
+  }
+}
+
+auto uniform_shadow::send() -> void {
+  for (std::size_t word = 0; word < dirty.size(); ++word) {
+    for (auto bits = dirty[word]; bits; bits &= bits - 1) {
+      const auto &s = slots[word * 64 + std::countr_zero(bits)];
+      // one call per array
+      upload(program, s.location, s.type, static_cast<int>(s.count),
+             values.data() + s.offset);
+    }
+    dirty[word] = 0;
+  }
+  queued = false;
+}
+
+auto uniform_shadow::flush_all() -> void {
+  auto &shadows = pending();
+  for (auto *shadow : shadows)
+    shadow->send();
+  shadows.clear();
+}
+
+} // namespace derp
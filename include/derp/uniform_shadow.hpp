@@ -0,0 +1,85 @@
+//===-- Implementation header for uniform shadow class --------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "program_reflection.hpp"
+
+#include <cassert>     // assert
+#include <concepts>    // std::same_as
+#include <cstddef>     // std::size_t, std::byte
+#include <cstdint>     // uint32_t, uint64_t
+#include <cstring>     // std::memcmp, std::memcpy
+#include <type_traits> // std::decay_t
+#include <vector>      // std::vector
+
+namespace derp {
+
+// CPU copy of one program's default block uniforms, sent at the next draw.
+//
+// A write compares the value with the copy and only marks the uniform dirty
+// if it differs, so a value set every frame that doesn't change (a static
+// projection) costs a memcmp and no GL call. flush_all() runs right before
+// every draw and dispatch and sends each dirty uniform with one
+// glProgramUniform*v, whichever program is bound. The copy starts out as what
+// GL holds after the link, layout(binding) initialisers included.
+class uniform_shadow {
+private:
+  struct slot {
+    int location;
+    uint32_t type;   // GL type, picks the glProgramUniform*v
+    uint32_t offset; // into values
+    uint32_t size;   // bytes of one element
+    uint32_t count;  // array size, 1 for plain uniforms
+  };
+
+  uint32_t program;
+  std::vector<slot> slots; // in reflection table order
+  std::vector<std::byte> values;
+  std::vector<uint64_t> dirty; // a bit per slot
+  bool queued = false;         // listed for flush_all()
+
+  // throws std::runtime_error, a `bytes` value doesn't fit entry `index`
+  [[noreturn]]
+  auto mismatch(std::size_t index, std::size_t bytes) const -> void;
+  auto mark(std::size_t index) -> void;
+  // sends the dirty uniforms
+  auto send() -> void;
+
+public:
+  uniform_shadow(uint32_t program, const program_reflection &reflection);
+  ~uniform_shadow();
+
+  uniform_shadow(const uniform_shadow &) = delete;
+  uniform_shadow &operator=(const uniform_shadow &) = delete;
+
+  // records `value` for entry `index` of the reflection table, as its first
+  // element. throws if the value is larger than an element
+  template <typename T>
+  auto write(const std::size_t index, const T &value) -> void {
+    using DecayedT = std::decay_t<T>;
+    if constexpr (std::same_as<DecayedT, bool>) {
+      write(index, static_cast<int>(value));
+    } else {
+      assert(index < slots.size());
+      if (sizeof(DecayedT) > slots[index].size)
+        mismatch(index, sizeof(DecayedT));
+      auto *copy = values.data() + slots[index].offset;
+      if (std::memcmp(copy, &value, sizeof(DecayedT)) == 0)
+        return;
+      std::memcpy(copy, &value, sizeof(DecayedT));
+      mark(index);
+    }
+  }
+
+  // sends the dirty uniforms of every program, call before drawing
+  static auto flush_all() -> void;
+}; // class uniform_shadow
+
+} // namespace derp
@@ -0,0 +1,188 @@
+//===-- Implementation of upload scheduler class --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "upload_scheduler.hpp"
+
+#include <algorithm>   // std::clamp, std::max, std::min
+#include <cstring>     // std::memcpy
+#include <type_traits> // std::is_same_v, std::decay_t
+#include <utility>     // std::move
+#include <variant>     // std::get_if, std::visit
+
+namespace derp {
+
+upload_scheduler::upload_scheduler(const std::size_t staging_size)
+    : staging(staging_size) {}
+
+upload_scheduler::~upload_scheduler() {
+  for (const auto &p : fences)
+    glDeleteSync(p.fence);
+}
+
+auto upload_scheduler::max_band() const noexcept -> std::size_t {
+  return std::max<std::size_t>(staging.get_capacity() / 4, 1);
+}
+
+auto upload_scheduler::upload_rows(std::shared_ptr<const void> owner,
+                                   const void *data,
+                                   const std::size_t row_bytes,
+                                   const int rows, row_writer write) -> void {
+  if (rows <= 0 || row_bytes == 0)
+    return;
+  queued += row_bytes * static_cast<std::size_t>(rows);
+  queue.emplace_back(rows_task{.owner = std::move(owner),
+                               .data = static_cast<const std::byte *>(data),
+                               .row_bytes = row_bytes,
+                               .rows = rows,
+                               .write = std::move(write)});
+}
+
+auto upload_scheduler::upload_buffer(std::shared_ptr<const void> owner,
+                                     const void *data, const std::size_t size,
+                                     const uint32_t buffer,
+                                     const std::size_t offset) -> void {
+  if (size == 0)
+    return;
+  queued += size;
+  queue.emplace_back(buffer_task{.owner = std::move(owner),
+                                 .data = static_cast<const std::byte *>(data),
+                                 .size = size,
+                                 .buffer = buffer,
+                                 .offset = offset});
+}
+
+auto upload_scheduler::then(callback done) -> void {
+  queue.emplace_back(marker{std::move(done)});
+}
+
+auto upload_scheduler::retire() -> void {
+  std::vector<callback> done;
+  while (!fences.empty()) {
+    int status = GL_UNSIGNALED;
+    glGetSynciv(fences.front().fence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED)
+      break;
+    glDeleteSync(fences.front().fence);
+    for (auto &fn : fences.front().done)
+      done.push_back(std::move(fn));
+    fences.pop_front();
+  }
+  // callbacks may queue new uploads, run them with the queue consistent
+  for (auto &fn : done)
+    fn();
+}
+
+auto upload_scheduler::issue(rows_task &task, const std::size_t bytes,
+                             const bool force, bool &finished) -> bool {
+  const auto left = task.rows - task.next;
+  const auto fit =
+      static_cast<int>(std::min(bytes, max_band()) / task.row_bytes);
+  if (fit == 0 && !force)
+    return false;
+  const int count = std::clamp(fit, 1, left);
+  const auto size = task.row_bytes * static_cast<std::size_t>(count);
+  const auto *src = task.data + task.row_bytes * task.next;
+
+  if (size > staging.get_capacity()) {
+    // a single row bigger than the ring, straight from client memory
+    task.write(task.next, count, src, size);
+  } else {
+    const auto offset = staging.allocate(size);
+    if (!offset)
+      return false;
+    std::memcpy(staging.data(*offset), src, size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.get_id());
+    task.write(task.next, count, reinterpret_cast<const void *>(*offset),
+               size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  }
+
+  task.next += count;
+  queued -= size;
+  finished = task.next == task.rows;
+  return true;
+}
+
+auto upload_scheduler::issue(buffer_task &task, const std::size_t bytes,
+                             bool /*force*/, bool &finished) -> bool {
+  const auto size = std::min({std::max<std::size_t>(bytes, 1), max_band(),
+                              task.size - task.done});
+  const auto offset = staging.allocate(size);
+  if (!offset)
+    return false;
+
+  std::memcpy(staging.data(*offset), task.data + task.done, size);
+  glCopyNamedBufferSubData(staging.get_id(), task.buffer,
+                           static_cast<GLintptr>(*offset),
+                           static_cast<GLintptr>(task.offset + task.done),
+                           static_cast<GLsizeiptr>(size));
+
+  task.done += size;
+  queued -= size;
+  finished = task.done == task.size;
+  return true;
+}
+
+auto upload_scheduler::submit(const budget &limit) -> std::size_t {
+  const auto start = std::chrono::steady_clock::now();
+  retire();
+
+  std::size_t issued = 0;
+  std::vector<callback> reached;
+  while (!queue.empty()) {
+    if (auto *m = std::get_if<marker>(&queue.front())) {
+      reached.push_back(std::move(m->done));
+      queue.pop_front();
+      continue;
+    }
+
+    // the first band of a frame may overshoot, the queue has to move
+    const bool out_of_bytes = limit.bytes && issued >= limit.bytes;
+    const bool out_of_time =
+        limit.time.count() &&
+        std::chrono::steady_clock::now() - start >= limit.time;
+    if (issued && (out_of_bytes || out_of_time))
+      break;
+
+    const auto bytes = limit.bytes ? limit.bytes - std::min(issued, limit.bytes)
+                                   : max_band();
+    const auto before = queued;
+    bool finished = false;
+    const bool progressed = std::visit(
+        [&](auto &task) {
+          if constexpr (std::is_same_v<std::decay_t<decltype(task)>, marker>)
+            return true;
+          else
+            return issue(task, bytes, issued == 0, finished);
+        },
+        queue.front());
+    if (!progressed)
+      break; // the GPU still reads the ring, or the budget is spent
+    issued += before - queued;
+    if (finished)
+      queue.pop_front();
+  }
+
+  if (issued || !reached.empty()) {
+    staging.fence();
+    fences.push_back(
+        {glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(reached)});
+  }
+  return issued;
+}
+
+auto upload_scheduler::backlog() const noexcept -> std::size_t {
+  return queued;
+}
+
+auto upload_scheduler::idle() const noexcept -> bool {
+  return queue.empty() && fences.empty();
+}
+
+} // namespace derp
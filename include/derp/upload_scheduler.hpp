@@ -0,0 +1,140 @@
+//===-- Implementation header for upload scheduler class ------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "staging_buffer.hpp"
+
+#include <chrono>     // std::chrono::microseconds
+#include <cstddef>    // std::byte, std::size_t
+#include <cstdint>    // uint32_t
+#include <deque>      // std::deque
+#include <functional> // std::move_only_function
+#include <memory>     // std::shared_ptr
+#include <variant>    // std::variant
+#include <vector>     // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+// Spreads texture and buffer uploads over as many frames as it takes to keep
+// each frame under a budget.
+//
+// Uploads are queued whole and cut into bands on submit(): texture levels by
+// rows (block rows for compressed ones), buffers by bytes. Every band is
+// copied into the persistently mapped staging ring and handed to GL from
+// there, so no call ever copies more than a band on the render thread.
+// submit() issues bands in queue order until the frame's byte or time budget
+// is spent; whatever is left goes out next frame.
+//
+// then() marks a point in the queue. Its callback runs on a later submit(),
+// once every upload queued before it has been issued and a fence shows the
+// GPU has consumed them: the moment to swap a texture in.
+class upload_scheduler {
+public:
+  static constexpr std::size_t DEFAULT_STAGING_SIZE = 64 * 1024 * 1024;
+
+  // whichever runs out first ends the frame's uploads, 0 is no limit
+  struct budget {
+    std::size_t bytes = 0;
+    std::chrono::microseconds time{0};
+  };
+
+  // issues rows [first, first + count) of an upload. `pixels` is an offset
+  // into the bound GL_PIXEL_UNPACK_BUFFER, or a client pointer for rows that
+  // don't fit the ring; `size` is count times the row size.
+  using row_writer = std::move_only_function<void(
+      int first, int count, const void *pixels, std::size_t size)>;
+
+  using callback = std::move_only_function<void()>;
+
+private:
+  struct rows_task {
+    std::shared_ptr<const void> owner; // keeps `data` alive
+    const std::byte *data;
+    std::size_t row_bytes;
+    int rows;
+    int next = 0;
+    row_writer write;
+  };
+
+  struct buffer_task {
+    std::shared_ptr<const void> owner;
+    const std::byte *data;
+    std::size_t size;
+    uint32_t buffer;
+    std::size_t offset;
+    std::size_t done = 0;
+  };
+
+  struct marker {
+    callback done;
+  };
+
+  struct pending {
+    GLsync fence;
+    std::vector<callback> done;
+  };
+
+  staging_buffer staging;
+  std::deque<std::variant<rows_task, buffer_task, marker>> queue;
+  std::deque<pending> fences; // oldest first
+  std::size_t queued = 0;     // bytes not issued yet
+
+  // largest band, so a few of them fit the ring at once
+  [[nodiscard]]
+  auto max_band() const noexcept -> std::size_t;
+
+  // runs the callbacks of signaled fences, oldest first
+  auto retire() -> void;
+
+  // issue up to `bytes` of a task, at least a row if `force`. false if the
+  // ring is full or not even a row fits
+  auto issue(rows_task &task, std::size_t bytes, bool force, bool &finished)
+      -> bool;
+  auto issue(buffer_task &task, std::size_t bytes, bool force,
+             bool &finished) -> bool;
+
+public:
+  explicit upload_scheduler(std::size_t staging_size = DEFAULT_STAGING_SIZE);
+  ~upload_scheduler();
+
+  upload_scheduler(const upload_scheduler &) = delete;
+  upload_scheduler &operator=(const upload_scheduler &) = delete;
+
+  // queues `rows` rows of `row_bytes` each starting at `data`, which `owner`
+  // keeps alive until they are issued
+  auto upload_rows(std::shared_ptr<const void> owner, const void *data,
+                   std::size_t row_bytes, int rows, row_writer write)
+      -> void;
+
+  // queues a write of `size` bytes to `buffer` at `offset`
+  auto upload_buffer(std::shared_ptr<const void> owner, const void *data,
+                     std::size_t size, uint32_t buffer, std::size_t offset)
+      -> void;
+
+  // runs `done` once everything queued so far is on the GPU
+  auto then(callback done) -> void;
+
+  // runs finished callbacks, then issues bands until `limit` is spent. at
+  // least one band goes out per call, so the queue always drains. returns
+  // the bytes issued.
+  auto submit(const budget &limit) -> std::size_t;
+
+  // bytes queued but not issued yet
+  [[nodiscard]]
+  auto backlog() const noexcept -> std::size_t;
+
+  // nothing queued and no callback waiting on the GPU
+  [[nodiscard]]
+  auto idle() const noexcept -> bool;
+}; // class upload_scheduler
+
+} // namespace derp
@@ -0,0 +1,548 @@
+//===-- Implementation of virtual texture class ---------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#include "virtual_texture.hpp"
+#include "gl_state.hpp"
+
+#include <algorithm>    // std::max, std::clamp, std::ranges::sort
+#include <bit>          // std::bit_ceil
+#include <cmath>        // std::log2
+#include <cstring>      // std::memcpy
+#include <format>       // std::format
+#include <fstream>      // std::ifstream, std::ofstream
+#include <print>        // std::println
+#include <stdexcept>    // std::runtime_error
+#include <system_error> // std::error_code
+#include <utility>      // std::pair
+
+namespace derp {
+
+namespace {
+
+constexpr std::array<char, 4> MAGIC = {'D', 'V', 'T', '2'};
+
+// one padded page as RGBA, texels outside the level repeat its edge
+auto cut_page(const image::level &level, const int channels,
+              const int page_size, const int border, const int px,
+              const int py, std::vector<unsigned char> &out) -> void {
+  const int padded = page_size + 2 * border;
+  for (int y = 0; y < padded; ++y) {
+    const int sy =
+        std::clamp(py * page_size - border + y, 0, level.height - 1);
+    for (int x = 0; x < padded; ++x) {
+      const int sx =
+          std::clamp(px * page_size - border + x, 0, level.width - 1);
+      const unsigned char *src =
+          level.pixels.get() +
+          (static_cast<std::size_t>(sy) * level.width + sx) * channels;
+      unsigned char *dst =
+          out.data() + (static_cast<std::size_t>(y) * padded + x) * 4;
+
+      switch (channels) {
+      case 1:
+        dst[0] = dst[1] = dst[2] = src[0];
+        dst[3] = 255;
+        break;
+      case 2:
+        dst[0] = dst[1] = dst[2] = src[0];
+        dst[3] = src[1];
+        break;
+      case 3:
+        std::memcpy(dst, src, 3);
+        dst[3] = 255;
+        break;
+      default:
+        std::memcpy(dst, src, 4);
+        break;
+      }
+    }
+  }
+}
+
+} // namespace
+
+//===-- virtual_texture ---------------------------------------------------===//
+
+auto virtual_texture::page_levels(const int width, const int height,
+                                  const int page_size) -> int {
+  int levels = 1;
+  while (std::max(width >> (levels - 1), height >> (levels - 1)) > page_size)
+    ++levels;
+  return levels;
+}
+
+auto virtual_texture::build(const image &img,
+                            const std::filesystem::path &path,
+                            const int page_size, const int border) -> bool {
+  if (img.block != block_format::NONE || img.type != pixel_type::UNORM8 ||
+      img.levels.empty())
+    return false;
+
+  const auto &base = img.levels.front();
+  const int levels = page_levels(base.width, base.height, page_size);
+  if (static_cast<int>(img.levels.size()) < levels)
+    return false;
+
+  header h{MAGIC,
+           static_cast<uint32_t>(base.width),
+           static_cast<uint32_t>(base.height),
+           static_cast<uint32_t>(page_size),
+           static_cast<uint32_t>(border),
+           static_cast<uint32_t>(levels),
+           img.srgb ? SRGB : 0};
+
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+
+  auto tmp = path;
+  tmp += ".tmp";
+  {
+    std::ofstream file{tmp, std::ios::binary | std::ios::trunc};
+    if (!file)
+      return false;
+    file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+
+    const int padded = page_size + 2 * border;
+    std::vector<unsigned char> buffer(static_cast<std::size_t>(padded) *
+                                      padded * 4);
+
+    // level by level, pages in row major order
+    for (int l = 0; l < levels; ++l) {
+      const auto &level = img.levels[l];
+      const int pages_x = (level.width + page_size - 1) / page_size;
+      const int pages_y = (level.height + page_size - 1) / page_size;
+      for (int py = 0; py < pages_y; ++py) {
+        for (int px = 0; px < pages_x; ++px) {
+          cut_page(level, img.channels, page_size, border, px, py, buffer);
+          file.write(reinterpret_cast<const char *>(buffer.data()),
+                     static_cast<std::streamsize>(buffer.size()));
+        }
+      }
+    }
+
+    if (!file)
+      return false;
+  }
+
+  std::filesystem::rename(tmp, path, ec);
+  return !ec;
+}
+
+virtual_texture::virtual_texture(std::filesystem::path path,
+                                 const uint32_t id, thread_pool &pool,
+                                 const int cache_pages,
+                                 const uint32_t max_in_flight)
+    : path(std::move(path)), id(id), pool(pool), cache_pages(cache_pages),
+      loader(std::make_shared<loader_state>()), max_in_flight(max_in_flight) {
+  std::ifstream file{this->path, std::ios::binary};
+  file.read(reinterpret_cast<char *>(&info), sizeof(info));
+  if (!file || info.magic != MAGIC || info.levels == 0) {
+    throw std::runtime_error(std::format(
+        "[ERROR] {} is not a virtual texture page file", this->path.string()));
+  }
+
+  // everything the shader sees goes through 8 bit integer texels
+  const auto [pages_x, pages_y] = pages(0);
+  if (id == 0 || id > 255 || pages_x > 256 || pages_y > 256 ||
+      cache_pages > 256) {
+    throw std::runtime_error(std::format(
+        "[ERROR] virtual texture {} exceeds the 8 bit page addressing",
+        this->path.string()));
+  }
+
+  uint64_t offset = sizeof(header);
+  for (uint32_t level = 0; level < info.levels; ++level) {
+    level_offsets.push_back(offset);
+    const auto [x, y] = pages(level);
+    offset += static_cast<uint64_t>(x) * y * page_bytes();
+  }
+
+  // the coarsest level is the fallback for everything, it never leaves. it
+  // fits in one page, read it before any GL object exists
+  const uint32_t top = info.levels - 1;
+  const auto top_key = make_key(top, 0, 0);
+  const auto base =
+      read_page(this->path, page_offset(top_key), page_bytes(), top_key);
+  if (base.pixels.empty()) {
+    throw std::runtime_error(std::format(
+        "[ERROR] couldn't load the base page of {}", this->path.string()));
+  }
+
+  // one level, pages are picked per level by the shader already
+  const int padded = static_cast<int>(info.page_size + 2 * info.border);
+  cache.allocate(cache_pages * padded, cache_pages * padded,
+                 {.channels = 4, .srgb = (info.flags & SRGB) != 0}, 1);
+  cache.set_sampler({.filtering = sampler_desc::filter::BILINEAR,
+                     .anisotropic = false});
+  slots.resize(static_cast<std::size_t>(cache_pages) * cache_pages);
+
+  // power of two pages per side, so every level's pages fit its mip
+  indirection_size = {static_cast<int>(std::bit_ceil(pages_x)),
+                      static_cast<int>(std::bit_ceil(pages_y))};
+  glCreateTextures(GL_TEXTURE_2D, 1, &indirection);
+  glTextureParameteri(indirection, GL_TEXTURE_MIN_FILTER,
+                      GL_NEAREST_MIPMAP_NEAREST);
+  glTextureParameteri(indirection, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTextureStorage2D(indirection, static_cast<GLsizei>(info.levels),
+                     GL_RGBA8UI, indirection_size[0], indirection_size[1]);
+
+  table.resize(info.levels);
+  for (uint32_t level = 0; level < info.levels; ++level) {
+    const auto w = std::max(1, indirection_size[0] >> level);
+    const auto h = std::max(1, indirection_size[1] >> level);
+    table[level].resize(static_cast<std::size_t>(w) * h);
+  }
+
+  upload(base, true);
+  rebuild_indirection();
+}
+
+virtual_texture::~virtual_texture() {
+  // jobs still running only hold on to the loader state
+  if (!indirection)
+    return;
+  gl_state::shared().forget_texture(indirection);
+  glDeleteTextures(1, &indirection);
+}
+
+auto virtual_texture::make_key(const uint32_t level, const uint32_t x,
+                               const uint32_t y) -> uint32_t {
+  return level << 24 | y << 12 | x;
+}
+
+auto virtual_texture::pages(const uint32_t level) const
+    -> std::array<uint32_t, 2> {
+  const auto w = std::max(1u, info.width >> level);
+  const auto h = std::max(1u, info.height >> level);
+  return {(w + info.page_size - 1) / info.page_size,
+          (h + info.page_size - 1) / info.page_size};
+}
+
+auto virtual_texture::page_bytes() const -> std::size_t {
+  const std::size_t padded = info.page_size + 2 * info.border;
+  return padded * padded * 4;
+}
+
+auto virtual_texture::page_offset(const uint32_t key) const -> uint64_t {
+  const uint32_t level = key >> 24;
+  const uint32_t y = key >> 12 & 0xFFF;
+  const uint32_t x = key & 0xFFF;
+  return level_offsets[level] +
+         (static_cast<uint64_t>(y) * pages(level)[0] + x) * page_bytes();
+}
+
+auto virtual_texture::read_page(const std::filesystem::path &path,
+                                const uint64_t offset, const std::size_t bytes,
+                                const uint32_t key) -> page {
+  page p{.key = key, .pixels = std::vector<unsigned char>(bytes)};
+  std::ifstream file{path, std::ios::binary};
+  file.seekg(static_cast<std::streamoff>(offset));
+  file.read(reinterpret_cast<char *>(p.pixels.data()),
+            static_cast<std::streamsize>(bytes));
+  if (!file)
+    p.pixels.clear();
+  return p;
+}
+
+auto virtual_texture::upload(const page &p, const bool pinned) -> bool {
+  // least recently used slot that no page of this frame sits in
+  std::size_t victim = slots.size();
+  for (std::size_t i = 0; i < slots.size(); ++i) {
+    const auto &s = slots[i];
+    if (s.pinned)
+      continue;
+    if (s.key == EMPTY) {
+      victim = i;
+      break;
+    }
+    if (s.last_used < frame &&
+        (victim == slots.size() || s.last_used < slots[victim].last_used))
+      victim = i;
+  }
+  if (victim == slots.size())
+    return false;
+
+  auto &s = slots[victim];
+  if (s.key != EMPTY)
+    resident.erase(s.key);
+  s = {p.key, frame, pinned};
+  resident[p.key] = static_cast<uint32_t>(victim);
+
+  const int padded = static_cast<int>(info.page_size + 2 * info.border);
+  const int x = static_cast<int>(victim) % cache_pages * padded;
+  const int y = static_cast<int>(victim) / cache_pages * padded;
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTextureSubImage2D(cache.id, 0, x, y, padded, padded, GL_RGBA,
+                      GL_UNSIGNED_BYTE, p.pixels.data());
+
+  table_dirty = true;
+  return true;
+}
+
+auto virtual_texture::rebuild_indirection() -> void {
+  // coarse to fine, so a missing page can copy its parent's entry
+  for (uint32_t level = info.levels; level-- > 0;) {
+    const int w = std::max(1, indirection_size[0] >> level);
+    const int h = std::max(1, indirection_size[1] >> level);
+    const int parent_w = std::max(1, indirection_size[0] >> (level + 1));
+    auto &entries = table[level];
+
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        auto &e = entries[static_cast<std::size_t>(y) * w + x];
+        const auto key = make_key(level, static_cast<uint32_t>(x),
+                                  static_cast<uint32_t>(y));
+        if (const auto it = resident.find(key); it != resident.end()) {
+          const auto slot = static_cast<int>(it->second);
+          e = {static_cast<uint8_t>(slot % cache_pages),
+               static_cast<uint8_t>(slot / cache_pages),
+               static_cast<uint8_t>(level), 255};
+        } else if (level + 1 < info.levels) {
+          e = table[level + 1][static_cast<std::size_t>(y >> 1) * parent_w +
+                               (x >> 1)];
+        } else {
+          e = {0, 0, static_cast<uint8_t>(level), 0};
+        }
+      }
+    }
+
+    glTextureSubImage2D(indirection, static_cast<GLint>(level), 0, 0, w, h,
+                        GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, entries.data());
+  }
+  table_dirty = false;
+}
+
+auto virtual_texture::request(uint32_t level, uint32_t x, uint32_t y)
+    -> void {
+  if (level >= info.levels)
+    return;
+  const auto [pages_x, pages_y] = pages(level);
+  if (x >= pages_x || y >= pages_y)
+    return; // garbage in the feedback buffer
+
+  // the ancestors are what the page falls back to while it loads
+  for (;; ++level, x >>= 1, y >>= 1) {
+    ++requested[make_key(level, x, y)];
+    if (level + 1 == info.levels)
+      break;
+  }
+}
+
+auto virtual_texture::update(const uint32_t max_uploads) -> void {
+  // pages in use this frame are safe from eviction
+  for (const auto &[key, count] : requested) {
+    if (const auto it = resident.find(key); it != resident.end())
+      slots[it->second].last_used = frame;
+  }
+
+  {
+    std::scoped_lock lock(loader->mutex);
+    for (auto &p : loader->done)
+      loaded.push_back(std::move(p));
+    loader->done.clear();
+  }
+
+  for (uint32_t uploads = 0; !loaded.empty() && uploads < max_uploads;) {
+    const auto p = std::move(loaded.front());
+    loaded.pop_front();
+    in_flight.erase(p.key);
+
+    if (p.pixels.empty()) {
+      std::println("[ERROR] Couldn't read page {:08x} of {}", p.key,
+                   path.string());
+      continue;
+    }
+    // a full cache drops the page, the feedback asks for it again
+    if (!resident.contains(p.key) && upload(p, false))
+      ++uploads;
+  }
+
+  // coarse levels first, they cover the most screen, then by demand
+  std::vector<std::pair<uint32_t, uint32_t>> missing;
+  for (const auto &[key, count] : requested) {
+    if (!resident.contains(key) && !in_flight.contains(key))
+      missing.emplace_back(key, count);
+  }
+  std::ranges::sort(missing, [](const auto &a, const auto &b) {
+    if (a.first >> 24 != b.first >> 24)
+      return a.first >> 24 > b.first >> 24;
+    return a.second > b.second;
+  });
+
+  for (const auto &[key, count] : missing) {
+    if (in_flight.size() >= max_in_flight)
+      break;
+    in_flight.insert(key);
+    pool.submit([state = loader, path = path, offset = page_offset(key),
+                 bytes = page_bytes(), key] {
+      auto p = read_page(path, offset, bytes, key);
+      std::scoped_lock lock(state->mutex);
+      state->done.push_back(std::move(p));
+    });
+  }
+
+  requested.clear();
+  ++frame;
+
+  if (table_dirty)
+    rebuild_indirection();
+}
+
+auto virtual_texture::size_uniform() const -> glm::vec4 {
+  return {static_cast<float>(info.width), static_cast<float>(info.height),
+          static_cast<float>(info.page_size), static_cast<float>(info.border)};
+}
+
+auto virtual_texture::use(const shader &s, const uint32_t cache_unit,
+                          const uint32_t indirection_unit) const -> void {
+  const auto padded = static_cast<float>(info.page_size + 2 * info.border);
+
+  cache.use(cache_unit);
+  gl_state::shared().bind_texture(indirection_unit, indirection);
+  s["u_vt_cache"] = static_cast<int>(cache_unit);
+  s["u_vt_indirection"] = static_cast<int>(indirection_unit);
+  s["u_vt_size"] = size_uniform();
+  s["u_vt_cache_size"] = glm::vec2(cache_pages * padded);
+  s["u_vt_max_level"] = static_cast<float>(info.levels - 1);
+}
+
+auto virtual_texture::use_feedback(const shader &s, const float bias) const
+    -> void {
+  s["u_vt_size"] = size_uniform();
+  s["u_vt_max_level"] = static_cast<float>(info.levels - 1);
+  s["u_vt_feedback_bias"] = bias;
+  s["u_vt_id"] = static_cast<int>(id);
+}
+
+auto virtual_texture::get_id() const noexcept -> uint32_t { return id; }
+
+auto virtual_texture::resident_pages() const noexcept -> std::size_t {
+  return resident.size();
+}
+
+//===-- feedback_buffer ---------------------------------------------------===//
+
+feedback_buffer::feedback_buffer(const int screen_width,
+                                 const int screen_height, const int scale)
+    : width(std::max(1, screen_width / scale)),
+      height(std::max(1, screen_height / scale)), scale(scale) {
+  glCreateTextures(GL_TEXTURE_2D, 1, &colour);
+  glTextureStorage2D(colour, 1, GL_RGBA8UI, width, height);
+
+  glCreateRenderbuffers(1, &depth);
+  glNamedRenderbufferStorage(depth, GL_DEPTH_COMPONENT24, width, height);
+
+  glCreateFramebuffers(1, &fbo);
+  glNamedFramebufferTexture(fbo, GL_COLOR_ATTACHMENT0, colour, 0);
+  glNamedFramebufferRenderbuffer(fbo, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER,
+                                 depth);
+  if (glCheckNamedFramebufferStatus(fbo, GL_FRAMEBUFFER) !=
+      GL_FRAMEBUFFER_COMPLETE) {
+    throw std::runtime_error("[ERROR] feedback framebuffer is incomplete");
+  }
+
+  const auto size = static_cast<GLsizeiptr>(width) * height * 4;
+  glCreateBuffers(static_cast<GLsizei>(pbo.size()), pbo.data());
+  for (const auto buffer : pbo)
+    glNamedBufferStorage(buffer, size, nullptr, GL_MAP_READ_BIT);
+}
+
+feedback_buffer::~feedback_buffer() {
+  for (auto fence : fences) {
+    if (fence)
+      glDeleteSync(fence);
+  }
+  glDeleteBuffers(static_cast<GLsizei>(pbo.size()), pbo.data());
+  gl_state::shared().forget_framebuffer(fbo);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &depth);
+  glDeleteTextures(1, &colour);
+}
+
+auto feedback_buffer::begin() -> void {
+  auto &state = gl_state::shared();
+  saved_viewport = state.get_viewport();
+  state.bind_framebuffer(fbo);
+  state.set_viewport(0, 0, width, height);
+
+  constexpr std::array<GLuint, 4> none{}; // id 0 means no request
+  constexpr float far = 1.0f;
+  glClearNamedFramebufferuiv(fbo, GL_COLOR, 0, none.data());
+  glClearNamedFramebufferfv(fbo, GL_DEPTH, 0, &far);
+}
+
+auto feedback_buffer::end() -> void {
+  // a read back nobody resolved in time is simply overwritten
+  if (fences[head])
+    glDeleteSync(fences[head]);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo[head]);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE,
+               nullptr);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  fences[head] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  head = (head + 1) % READBACKS;
+
+  auto &state = gl_state::shared();
+  state.bind_framebuffer(0);
+  state.set_viewport(saved_viewport[0], saved_viewport[1], saved_viewport[2],
+                     saved_viewport[3]);
+}
+
+auto feedback_buffer::resolve(std::span<virtual_texture *const> textures)
+    -> void {
+  const auto size = static_cast<GLsizeiptr>(width) * height * 4;
+
+  // oldest first
+  for (std::size_t n = 0; n < READBACKS; ++n) {
+    const auto i = (head + n) % READBACKS;
+    auto &fence = fences[i];
+    if (!fence)
+      continue;
+
+    GLint status = GL_UNSIGNALED;
+    glGetSynciv(fence, GL_SYNC_STATUS, 1, nullptr, &status);
+    if (status != GL_SIGNALED)
+      continue;
+    glDeleteSync(fence);
+    fence = nullptr;
+
+    const auto *texels = static_cast<const uint8_t *>(
+        glMapNamedBufferRange(pbo[i], 0, size, GL_MAP_READ_BIT));
+    if (!texels)
+      continue;
+
+    // neighbouring texels mostly ask for the same page
+    std::unordered_set<uint32_t> seen;
+    for (GLsizeiptr t = 0; t < size; t += 4) {
+      const uint8_t *f = texels + t;
+      if (f[3] == 0)
+        continue;
+      uint32_t value;
+      std::memcpy(&value, f, sizeof(value));
+      if (!seen.insert(value).second)
+        continue;
+
+      for (auto *vt : textures) {
+        if (vt && vt->get_id() == f[3]) {
+          vt->request(f[2], f[0], f[1]);
+          break;
+        }
+      }
+    }
+    glUnmapNamedBuffer(pbo[i]);
+  }
+}
+
+auto feedback_buffer::bias() const noexcept -> float {
+  return -std::log2(static_cast<float>(scale));
+}
+
+} // namespace derp
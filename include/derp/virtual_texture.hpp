@@ -0,0 +1,216 @@
+//===-- Implementation header for virtual texture class -------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "image.hpp"
+#include "shader.hpp"
+#include "texture.hpp"
+#include "thread_pool.hpp"
+
+#include <array>         // std::array
+#include <cstddef>       // std::size_t
+#include <cstdint>       // uint8_t, uint32_t, uint64_t
+#include <deque>         // std::deque
+#include <filesystem>    // std::filesystem::path
+#include <memory>        // std::shared_ptr
+#include <mutex>         // std::mutex
+#include <span>          // std::span
+#include <unordered_map> // std::unordered_map
+#include <unordered_set> // std::unordered_set
+#include <vector>        // std::vector
+
+#include <glad/glad.h>
+
+namespace derp {
+
+// Software virtual texturing for textures too big to keep in memory, plain
+// GL 4.6, no sparse textures.
+//
+// build() cuts an image's mip chain into square pages with a border and
+// stores them in a page file. At runtime only the pages the camera needs
+// live in a physical cache texture; an indirection texture with one texel
+// per virtual page (and one mip per virtual level) tells the shader which
+// cache slot holds a page. Pages that are not resident resolve to their
+// closest resident ancestor, the coarsest level is always resident.
+//
+// Which pages are needed comes from feedback_buffer: draw the scene with
+// virtual_feedback.frag into it at a fraction of the screen resolution, and
+// resolve() the read back a few frames later into request() calls. update()
+// then loads the missing pages on the pool, coarse levels first, and uploads
+// finished ones into the least recently used cache slots. Sample the result
+// with virtual_texture.frag in place of texture.frag.
+class virtual_texture {
+public:
+  static constexpr int PAGE_SIZE = 128;
+  static constexpr int BORDER = 4;       // texels copied from the neighbours
+  static constexpr int CACHE_PAGES = 16; // slots per side of the cache
+
+  // writes the pages of `img` (UNORM8, uncompressed, with mips down to a
+  // single page) to `path`
+  static auto build(const image &img, const std::filesystem::path &path,
+                    int page_size = PAGE_SIZE, int border = BORDER) -> bool;
+
+  // levels build() needs in an image of this size
+  [[nodiscard]]
+  static auto page_levels(int width, int height, int page_size = PAGE_SIZE)
+      -> int;
+
+private:
+  struct header {
+    std::array<char, 4> magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t page_size;
+    uint32_t border;
+    uint32_t levels;
+    uint32_t flags;
+  };
+  static_assert(sizeof(header) == 28);
+
+  static constexpr uint32_t SRGB = 1; // header flag, pages are sRGB colour
+
+  struct page {
+    uint32_t key;
+    std::vector<unsigned char> pixels; // empty if the read failed
+  };
+
+  // shared with the loader jobs, which may outlive the texture
+  struct loader_state {
+    std::mutex mutex;
+    std::vector<page> done;
+  };
+
+  static constexpr uint32_t EMPTY = ~0u;
+
+  struct slot {
+    uint32_t key = EMPTY;
+    uint64_t last_used = 0;
+    bool pinned = false;
+  };
+
+  using entry = std::array<uint8_t, 4>; // slot xy, level held, valid
+
+  std::filesystem::path path;
+  header info{};
+  std::vector<uint64_t> level_offsets; // byte offset of each level's pages
+  uint32_t id;
+  thread_pool &pool;
+
+  texture cache{texture::texture_type::DIFFUSE};
+  int cache_pages;
+  uint32_t indirection = 0;
+  std::array<int, 2> indirection_size{};
+  std::vector<std::vector<entry>> table; // CPU copy of every level
+
+  std::vector<slot> slots;
+  std::unordered_map<uint32_t, uint32_t> resident;  // page key to slot
+  std::unordered_map<uint32_t, uint32_t> requested; // page key to count
+  std::unordered_set<uint32_t> in_flight;
+  std::deque<page> loaded; // read, waiting for an upload
+  std::shared_ptr<loader_state> loader;
+
+  uint64_t frame = 1;
+  bool table_dirty = true;
+  uint32_t max_in_flight;
+
+  static auto make_key(uint32_t level, uint32_t x, uint32_t y) -> uint32_t;
+
+  [[nodiscard]]
+  auto pages(uint32_t level) const -> std::array<uint32_t, 2>;
+  [[nodiscard]]
+  auto page_bytes() const -> std::size_t;
+  [[nodiscard]]
+  auto page_offset(uint32_t key) const -> uint64_t;
+
+  // runs on the workers, must not touch the texture
+  static auto read_page(const std::filesystem::path &path, uint64_t offset,
+                        std::size_t bytes, uint32_t key) -> page;
+  auto upload(const page &p, bool pinned) -> bool;
+  auto rebuild_indirection() -> void;
+
+  // u_vt_size: virtual width, height, page size, border
+  [[nodiscard]]
+  auto size_uniform() const -> glm::vec4;
+
+public:
+  // `id` (1 - 255) tells the textures apart in the feedback buffer
+  virtual_texture(std::filesystem::path path, uint32_t id, thread_pool &pool,
+                  int cache_pages = CACHE_PAGES, uint32_t max_in_flight = 8);
+  ~virtual_texture();
+
+  virtual_texture(const virtual_texture &) = delete;
+  virtual_texture &operator=(const virtual_texture &) = delete;
+
+  // asks for a page and its ancestors to be made resident
+  auto request(uint32_t level, uint32_t x, uint32_t y) -> void;
+
+  // uploads up to `max_uploads` finished pages, queues the most important
+  // missing ones and refreshes the indirection texture. once per frame.
+  auto update(uint32_t max_uploads = 8) -> void;
+
+  // binds the cache and indirection textures and sets the uniforms of
+  // virtual_texture.frag, `s` must be in use
+  auto use(const shader &s, uint32_t cache_unit = 0,
+           uint32_t indirection_unit = 1) const -> void;
+
+  // sets the uniforms of virtual_feedback.frag, `s` must be in use
+  auto use_feedback(const shader &s, float bias) const -> void;
+
+  [[nodiscard]]
+  auto get_id() const noexcept -> uint32_t;
+
+  [[nodiscard]]
+  auto resident_pages() const noexcept -> std::size_t;
+}; // class virtual_texture
+
+// Low resolution render target the feedback pass draws page requests into.
+// Read backs go through a small ring of pixel pack buffers, resolve() only
+// consumes the ones the GPU has finished, so it never stalls.
+class feedback_buffer {
+public:
+  static constexpr int DEFAULT_SCALE = 8;
+  static constexpr std::size_t READBACKS = 3;
+
+private:
+  uint32_t fbo = 0;
+  uint32_t colour = 0;
+  uint32_t depth = 0;
+  int width;
+  int height;
+  int scale;
+
+  std::array<uint32_t, READBACKS> pbo{};
+  std::array<GLsync, READBACKS> fences{};
+  std::size_t head = 0;
+  std::array<int, 4> saved_viewport{};
+
+public:
+  feedback_buffer(int screen_width, int screen_height,
+                  int scale = DEFAULT_SCALE);
+  ~feedback_buffer();
+
+  feedback_buffer(const feedback_buffer &) = delete;
+  feedback_buffer &operator=(const feedback_buffer &) = delete;
+
+  // binds and clears the target, draw the scene with the feedback shader
+  // until end()
+  auto begin() -> void;
+  auto end() -> void;
+
+  // hands the requests of every finished read back to `textures`, which
+  // are looked up by their id
+  auto resolve(std::span<virtual_texture *const> textures) -> void;
+
+  // level bias of the feedback shader, it sees coarser derivatives
+  [[nodiscard]]
+  auto bias() const noexcept -> float;
+}; // class feedback_buffer
+
+} // namespace derp
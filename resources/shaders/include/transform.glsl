@@ -0,0 +1,21 @@
+// object to world to clip space for the object being drawn, its index in
+// objects comes in as gl_BaseInstance (see derp::mesh::draw)
+
+#include "frame_data.glsl"
+#include "object_data.glsl"
+
+mat4 object_model() {
+    return objects[gl_BaseInstance].model;
+}
+
+mat3 object_normal() {
+    return mat3(objects[gl_BaseInstance].normal);
+}
+
+vec4 world_to_clip(vec4 world) {
+    return frame.projection * frame.view * world;
+}
+
+vec4 object_to_clip(vec3 pos) {
+    return world_to_clip(object_model() * vec4(pos, 1.0));
+}
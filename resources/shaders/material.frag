@@ -0,0 +1,128 @@
+#version 460 core
+#ifdef BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+layout(location=0) in vec3 world_pos;
+layout(location=1) in vec3 world_nrm;
+layout(location=2) in vec2 tex_coord;
+layout(location=3) flat in uint material;
+
+// see derp::material, maps a material lacks sample as neutral placeholders.
+// with TEXTURE_ARRAYS the units hold the arrays the maps were packed into,
+// material_data says which layer and region; maps without one read as the
+// same neutral values. with BINDLESS the units go unused, material_data
+// indexes the handles of derp::bindless_table instead
+#if defined(TEXTURE_ARRAYS) || defined(BINDLESS)
+#include "material_data.glsl"
+#endif
+#ifdef BINDLESS
+layout(std430, binding = 2) readonly buffer bindless_handles {
+    uvec2 handles[];
+};
+#endif
+#ifdef TEXTURE_ARRAYS
+#define map_sampler sampler2DArray
+#else
+#define map_sampler sampler2D
+#endif
+layout(binding=0) uniform map_sampler u_albedo;
+layout(binding=1) uniform map_sampler u_normal_height; // normal xy, height a
+layout(binding=2) uniform map_sampler u_orm; // occlusion, roughness, metal
+
+const vec4 neutral[3] = vec4[](vec4(1.0), vec4(0.5, 0.5, 1.0, 1.0),
+                               vec4(1.0, 1.0, 0.0, 1.0));
+
+#include "frame_data.glsl"
+
+// features: specialization constants when built from SPIR-V, defines when
+// built from GLSL. constant ids follow the feature bits of derp's
+// shader_permutations
+#ifdef GL_SPIRV
+layout(constant_id = 0) const bool parallax = false;
+#elif defined(PARALLAX)
+const bool parallax = true;
+#else
+const bool parallax = false;
+#endif
+
+out vec4 frag_color;
+
+#ifdef TEXTURE_ARRAYS
+// uv_rect applies to the flipped coordinates, both are in storage space.
+// fract() keeps atlas regions off their neighbours, the gradients of the
+// unwrapped coordinates keep the mip choice steady across the wrap
+vec4 sample_map(sampler2DArray map, uint unit, vec2 uv) {
+    uint layer = materials[material].maps[unit];
+    if (layer == 0xFFFFFFFFu)
+        return neutral[unit];
+    vec4 rect = materials[material].rects[unit];
+    return textureGrad(map, vec3(rect.xy + fract(uv) * rect.zw, layer),
+                       dFdx(uv) * rect.zw, dFdy(uv) * rect.zw);
+}
+#elif defined(BINDLESS)
+// placeholders stand in for maps that are missing, streaming or evicted
+vec4 sample_map(sampler2D map, uint unit, vec2 uv) {
+    return texture(sampler2D(handles[materials[material].maps[unit]]), uv);
+}
+#else
+vec4 sample_map(sampler2D map, uint unit, vec2 uv) {
+    return texture(map, uv);
+}
+#endif
+
+// tangent frame from screen space derivatives, the meshes carry no tangents
+mat3 cotangent_frame(vec3 n, vec3 p, vec2 uv) {
+    vec3 dp1 = dFdx(p);
+    vec3 dp2 = dFdy(p);
+    vec2 duv1 = dFdx(uv);
+    vec2 duv2 = dFdy(uv);
+
+    vec3 dp2perp = cross(dp2, n);
+    vec3 dp1perp = cross(n, dp1);
+    vec3 t = dp2perp * duv1.x + dp1perp * duv2.x;
+    vec3 b = dp2perp * duv1.y + dp1perp * duv2.y;
+    float scale = inversesqrt(max(dot(t, t), dot(b, b)));
+    return mat3(t * scale, b * scale, n);
+}
+
+void main() {
+    vec3 n = normalize(world_nrm);
+    vec3 v = normalize(frame.eye - world_pos);
+    mat3 tbn = cotangent_frame(n, world_pos, tex_coord);
+
+    vec2 uv = tex_coord;
+    if (parallax) {
+        // offset parallax: one extra fetch of the packed texture for the
+        // height, a height of 1 (the placeholder) leaves the coordinates alone
+        vec3 v_tangent = normalize(transpose(tbn) * v);
+        float height = sample_map(u_normal_height, 1u, tex_coord).a;
+        uv -= v_tangent.xy / max(v_tangent.z, 0.25) * (1.0 - height) *
+              frame.height_scale;
+    }
+
+    vec4 albedo = sample_map(u_albedo, 0u, uv);
+    vec4 normal_height = sample_map(u_normal_height, 1u, uv);
+    vec3 orm = sample_map(u_orm, 2u, uv).rgb;
+
+    // the normal map only keeps xy
+    vec2 xy = normal_height.xy * 2.0 - 1.0;
+    vec3 mapped = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+    // the frame is built on the flipped v of the vertex shader, its b points
+    // down the image while the map's +y is up
+    mapped.y = -mapped.y;
+    n = normalize(tbn * mapped);
+
+    vec3 l = normalize(frame.light_dir);
+    vec3 h = normalize(l + v);
+    float roughness = max(orm.g, 0.05);
+    float shininess = 2.0 / (roughness * roughness * roughness * roughness);
+    vec3 f0 = mix(vec3(0.04), albedo.rgb, orm.b);
+
+    vec3 diffuse = albedo.rgb * (1.0 - orm.b) * max(dot(n, l), 0.0);
+    vec3 specular = f0 * pow(max(dot(n, h), 0.0), shininess) *
+                    max(dot(n, l), 0.0);
+    vec3 ambient = 0.03 * albedo.rgb * orm.r;
+
+    frag_color = vec4(diffuse + specular + ambient, albedo.a);
+}
@@ -0,0 +1,28 @@
+#version 460 core
+
+layout(location=0) in vec3 a_pos;
+layout(location=1) in vec3 a_nrm;
+layout(location=2) in vec2 a_tex;
+
+#include "transform.glsl"
+
+// built as a separable program: the outputs match the fragment stage by
+// location, and gl_PerVertex has to be declared
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+layout(location=0) out vec3 world_pos;
+layout(location=1) out vec3 world_nrm;
+layout(location=2) out vec2 tex_coord;
+layout(location=3) flat out uint material; // see derp::material_table
+
+void main() {
+    vec4 world = object_model() * vec4(a_pos, 1.0);
+    gl_Position = world_to_clip(world);
+    world_pos = world.xyz;
+    world_nrm = object_normal() * a_nrm;
+    // images are stored top row first, v = 0 is the bottom of the image
+    tex_coord = vec2(a_tex.x, 1.0 - a_tex.y);
+    material = objects[gl_BaseInstance].material;
+}
@@ -4,13 +4,12 @@ layout(location=0) in vec3 a_pos;
 layout(location=1) in vec2 a_nrm;
 layout(location=2) in vec2 a_tex;
 
-uniform mat4 u_model;
-uniform mat4 u_projection;
-uniform mat4 u_view;
+#include "transform.glsl"
 
 out vec2 tex_coord;
 
 void main() {
-    gl_Position = u_projection * u_view * u_model * vec4(a_pos, 1.0);
-    tex_coord = a_tex;
+    gl_Position = object_to_clip(a_pos);
+    // images are stored top row first, v = 0 is the bottom of the image
+    tex_coord = vec2(a_tex.x, 1.0 - a_tex.y);
 }
@@ -7,5 +7,6 @@ out vec2 tex_coord;
 
 void main() {
     gl_Position = vec4(a_pos, 1.0);
-    tex_coord = a_tex;
+    // images are stored top row first, v = 0 is the bottom of the image
+    tex_coord = vec2(a_tex.x, 1.0 - a_tex.y);
 }
@@ -0,0 +1,27 @@
+#version 460 core
+
+in vec2 tex_coord;
+
+uniform vec4 u_vt_size; // virtual width, height, page size, border
+uniform float u_vt_max_level;
+uniform float u_vt_feedback_bias; // the pass runs at a lower resolution
+uniform int u_vt_id;
+
+out uvec4 feedback; // page xy, level, texture id (0 is no request)
+
+float vt_level(vec2 uv) {
+    vec2 texels = uv * u_vt_size.xy;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    return clamp(lod + u_vt_feedback_bias, 0.0, u_vt_max_level);
+}
+
+void main() {
+    vec2 uv = clamp(tex_coord, vec2(0.0), vec2(0.99999));
+    int level = int(vt_level(uv));
+
+    vec2 level_size = max(floor(u_vt_size.xy / exp2(level)), vec2(1.0));
+    uvec2 page = uvec2(uv * level_size / u_vt_size.z);
+    feedback = uvec4(page, uint(level), uint(u_vt_id));
+}
@@ -0,0 +1,38 @@
+#version 460 core
+
+in vec2 tex_coord;
+
+uniform sampler2D u_vt_cache;        // physical pages, each with a border
+uniform usampler2D u_vt_indirection; // per page: cache slot xy, level held
+uniform vec4 u_vt_size;              // virtual width, height, page size, border
+uniform vec2 u_vt_cache_size;        // physical cache in texels
+uniform float u_vt_max_level;
+
+out vec4 frag_color;
+
+float vt_level(vec2 uv) {
+    vec2 texels = uv * u_vt_size.xy;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    return clamp(lod, 0.0, u_vt_max_level);
+}
+
+vec2 vt_level_size(float level) {
+    return max(floor(u_vt_size.xy / exp2(level)), vec2(1.0));
+}
+
+void main() {
+    vec2 uv = clamp(tex_coord, vec2(0.0), vec2(0.99999));
+    int level = int(vt_level(uv));
+
+    ivec2 page = ivec2(uv * vt_level_size(level) / u_vt_size.z);
+    uvec4 entry = texelFetch(u_vt_indirection, page, level);
+
+    // the entry points at a coarser page while the requested one streams in
+    vec2 in_page = fract(uv * vt_level_size(float(entry.z)) / u_vt_size.z);
+
+    float padded = u_vt_size.z + 2.0 * u_vt_size.w;
+    vec2 texel = vec2(entry.xy) * padded + u_vt_size.w + in_page * u_vt_size.z;
+    frag_color = textureLod(u_vt_cache, texel / u_vt_cache_size, 0.0);
+}
@@ -8,12 +8,28 @@
 //===----------------------------------------------------------------------===//
 
 #include "derp/camera.hpp"
+#include "derp/compute_program.hpp"
+#include "derp/gl_state.hpp"
+#include "derp/material.hpp"
+#include "derp/material_table.hpp"
+#include "derp/memory_barriers.hpp"
 #include "derp/mesh.hpp"
+#include "derp/occlusion.hpp"
+#include "derp/pipeline_cache.hpp"
+#include "derp/program_cache.hpp"
+#include "derp/shader_compiler.hpp"
+#include "derp/shader_permutations.hpp"
+#include "derp/shader_reloader.hpp"
 #include "derp/texture.hpp"
+#include "derp/texture_streamer.hpp"
+#include "derp/typed_buffer.hpp"
+#include "shader_blocks.hpp"
 
 #include <derp/shader.hpp>
 
+#include <array>
 #include <iostream>
+#include <optional>
 #include <print>
 
 #include <glad/glad.h>
@@ -24,7 +40,7 @@ constexpr int WIDTH = 800;
 constexpr int HEIGHT = 600;
 
 void fb_resize_callback(GLFWwindow *window, const int width, const int height) {
-  glViewport(0, 0, width, height);
+  derp::gl_state::shared().set_viewport(0, 0, width, height);
 }
 
 void mouse_callback(GLFWwindow *window, double x, double y);
@@ -54,6 +70,7 @@ int main() {
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   glfwWindowHint(GLFW_SAMPLES, 4);
+  glfwWindowHint(GLFW_SRGB_CAPABLE, GLFW_TRUE);
 
   // glfwWindowHint(GLFW_DECORATED, false);
   glfwWindowHint(GLFW_RESIZABLE, false);
@@ -88,7 +105,7 @@ int main() {
   {
     int fbSizeX, fbSizeY;
     glfwGetFramebufferSize(window, &fbSizeX, &fbSizeY);
-    glViewport(0, 0, fbSizeX, fbSizeY);
+    derp::gl_state::shared().set_viewport(0, 0, fbSizeX, fbSizeY);
   }
 
   glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
@@ -100,6 +117,9 @@ int main() {
   }
 
   glEnable(GL_DEPTH_TEST);
+  // colour textures are sampled as linear values, shade linear and let GL
+  // encode on write
+  glEnable(GL_FRAMEBUFFER_SRGB);
 
   {
     const auto *vertex_data =
@@ -111,27 +131,124 @@ int main() {
 
     derp::mesh m(std::move(cube_vert), std::move(cube_ind));
 
-    derp::shader s(RESOURCES_PATH "/shaders/normal.vert",
-                   RESOURCES_PATH "/shaders/texture.frag");
-    s.use();
-
     auto model = glm::identity<glm::mat4>();
 
     const auto projection =
         glm::perspective(glm::radians(cs.camera.get_fov()),
                          static_cast<float>(WIDTH) / HEIGHT, 0.1f, 500.0f);
-    s["u_projection"] = projection;
 
-    derp::texture t(RESOURCES_PATH "/textures/container.png");
-    t.use();
+    // bound once, programs #include the generated declarations
+    derp::uniform_buffer<frame_data> frame;
+    derp::storage_buffer<object_data> objects(OBJECTS);
+    frame.bind();
+    objects.bind();
+
+    // programs build in the background, each gets drawn once it's ready
+    derp::shader_compiler compiler;
+    auto &preprocessor = compiler.get_preprocessor();
+    add_shader_blocks(preprocessor);
+    std::println("[INFO] shader compile: {}",
+                 derp::shader_compiler::supported() ? "parallel" : "serial");
+    std::println("[INFO] separable stages: {}",
+                 derp::shader_compiler::spirv_supported() ? "SPIR-V" : "GLSL");
+
+    // edited shaders rebuild in the background and replace the running
+    // programs between frames, a broken edit keeps the last good one
+    derp::shader_reloader reloader(compiler);
+
+    std::optional<derp::shader> s;
+    const auto build_cube = [&] {
+      compiler.submit(RESOURCES_PATH "/shaders/normal.vert",
+                      RESOURCES_PATH "/shaders/texture.frag",
+                      [&](derp::shader_compiler::result built) {
+                        if (!built) {
+                          std::println("{}", built.error());
+                          return;
+                        }
+                        s = std::move(*built);
+                      });
+    };
+    build_cube();
+    reloader.track(build_cube);
+
+    // normal matrices are derived on the GPU, the draws read what it wrote
+    std::optional<derp::compute_program> object_normals;
+    const auto build_object_normals = [&] {
+      compiler.submit_compute(
+          RESOURCES_PATH "/shaders/object_normals.comp", {},
+          [&](derp::shader_compiler::result built) {
+            if (!built) {
+              std::println("{}", built.error());
+              return;
+            }
+            object_normals.emplace(std::move(*built));
+            object_normals->bind(objects, derp::access::READ_WRITE);
+          });
+    };
+    build_object_normals();
+    reloader.track(build_object_normals);
+
+    // materials find their maps through the table: bindless handles when
+    // the driver has them, texture arrays when it doesn't (llvmpipe)
+    derp::material_table materials;
+    materials.bind();
+    const bool bindless =
+        materials.get_path() == derp::material_table::path::BINDLESS;
+    std::println("[INFO] material textures: {}",
+                 bindless ? "bindless" : "texture arrays");
+
+    // the material stages are separate programs paired in a pipeline, P
+    // toggles parallax, both fragment variants are built up front and share
+    // the one vertex program. the table's path changes the sampler types,
+    // so its variants are always built from GLSL
+    constexpr derp::shader_permutations::features PARALLAX = 1u << 0;
+    constexpr derp::shader_permutations::features TEXTURE_ARRAYS = 1u << 1;
+    constexpr derp::shader_permutations::features BINDLESS = 1u << 2;
+    derp::shader_permutations material_vert(
+        compiler, GL_VERTEX_SHADER, RESOURCES_PATH "/shaders/material.vert",
+        {});
+    derp::shader_permutations material_frag(
+        compiler, GL_FRAGMENT_SHADER, RESOURCES_PATH "/shaders/material.frag",
+        {"PARALLAX", "TEXTURE_ARRAYS", "BINDLESS"}, TEXTURE_ARRAYS | BINDLESS);
+    const derp::shader_permutations::features material_path =
+        bindless ? BINDLESS : TEXTURE_ARRAYS;
+    const std::array<derp::shader_permutations::features, 1> plain{0};
+    const std::array<derp::shader_permutations::features, 2> variants{
+        material_path, material_path | PARALLAX};
+    material_vert.prepare(plain);
+    reloader.track([&] { material_vert.rebuild(); });
+    material_frag.prepare(variants);
+    reloader.track([&] { material_frag.rebuild(); });
+    derp::shader_permutations::features material_features =
+        material_path | PARALLAX;
+    bool parallax_key = false;
+
+    derp::texture_streamer streamer;
+    streamer.set_view(glm::radians(cs.camera.get_fov()), HEIGHT);
+    const auto t = streamer.load(RESOURCES_PATH "/textures/container.png");
 
     auto m_test =
         derp::mesh::from_obj(RESOURCES_PATH "/models/mario/mario.obj");
 
-    m.use();
+    auto mtl = derp::read_mtl(RESOURCES_PATH "/models/mario/Mario.mtl");
+    if (!mtl || mtl->empty()) {
+      std::println("[ERROR] Couldn't read Mario.mtl: {}",
+                   mtl ? "no materials" : mtl.error());
+      mtl = std::vector<derp::material_maps>(1);
+    }
+    // mario is stored the way the table's path wants it
+    const derp::material m_test_material(
+        mtl->front(), streamer,
+        derp::material::storage_for(materials.get_path()));
+    const auto m_test_material_id = materials.add(m_test_material);
+
+    derp::occlusion_culler culler;
+    const auto m_test_id = culler.add();
+
+    derp::program_cache::shared().report();
 
     while (!glfwWindowShouldClose(window)) {
-      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClearColor(0.01f, 0.01f, 0.01f, 1.0f); // 0.1 in sRGB
       glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
       const auto current_frame = static_cast<float>(glfwGetTime());
@@ -140,12 +257,70 @@ int main() {
 
       process_input(window);
 
-      s["u_model"] = model;
-      s["u_view"] = cs.camera.get_view_matrix();
-
-      m.draw();
-
-      m_test.use_and_draw();
+      const bool parallax_down = glfwGetKey(window, GLFW_KEY_P);
+      if (parallax_down && !parallax_key)
+        material_features ^= PARALLAX;
+      parallax_key = parallax_down;
+
+      reloader.poll();
+      compiler.poll();
+      streamer.update(std::chrono::microseconds(2000));
+      t->use();
+
+      const auto view = cs.camera.get_view_matrix();
+      culler.begin_frame(view, projection, cs.camera.get_position());
+
+      // one write each for everything shaders read of the frame and objects
+      const auto eye = cs.camera.get_position();
+      frame.write({.projection = projection,
+                   .view = view,
+                   .eye = eye,
+                   .time = current_frame,
+                   .light_dir = glm::vec3(0.3f, 1.0f, 0.5f),
+                   .height_scale = 0.02f});
+      // until object_normals is built the CPU fills in the normal matrices
+      const glm::mat4 normal =
+          object_normals
+              ? glm::mat4(1.0f)
+              : glm::mat4(glm::transpose(glm::inverse(glm::mat3(model))));
+      objects.write(std::array<object_data, OBJECTS>{
+          {{model, normal}, {model, normal, m_test_material_id}}});
+      if (object_normals) {
+        object_normals->dispatch(object_normals->groups_for({OBJECTS, 1, 1}));
+        auto &barriers = derp::memory_barriers::shared();
+        barriers.need(derp::gpu_resource::BUFFER, objects.get_id(),
+                      GL_SHADER_STORAGE_BARRIER_BIT);
+        barriers.flush();
+      }
+
+      // the cube sits at the origin unscaled, its bounds are world space
+      const auto &cube = m.get_bounds();
+      streamer.request_mips(
+          *t, m.get_uv_density(),
+          glm::distance(eye, glm::clamp(eye, cube.min, cube.max)));
+
+      if (s) {
+        s->use();
+        m.use_and_draw(CUBE);
+      }
+
+      // the cube is the occluder, mario only gets drawn when it peeks out
+      culler.test(m_test_id, m_test.get_bounds(), model);
+
+      m_test_material.request_mips(
+          streamer, m_test.get_uv_density(),
+          glm::distance(eye, glm::clamp(eye, m_test.get_bounds().min,
+                                        m_test.get_bounds().max)));
+      materials.mark_visible(m_test_material_id);
+      materials.update();
+
+      const auto *vert = material_vert.get(0);
+      const auto *frag = material_frag.get(material_features);
+      if (vert && frag) {
+        derp::pipeline_cache::shared().bind(*vert, *frag);
+        materials.use(m_test_material_id);
+        culler.draw(m_test_id, [&] { m_test.use_and_draw(MARIO); });
+      }
 
       glfwSwapBuffers(window);
       glfwPollEvents();
@@ -0,0 +1,79 @@
+//===-- Blocks shared by the shaders and the CPU --------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "derp/glsl_preprocessor.hpp"
+#include "derp/material_table.hpp"
+#include "derp/typed_buffer.hpp"
+
+#include <array>       // std::array
+#include <cstdint>     // uint32_t
+#include <string_view> // std::string_view
+
+#include <glm/glm.hpp>
+
+// what every shader sees of the frame, one uniform block
+// projection first: uniform_buffer only uploads from the first changed byte
+struct frame_data {
+  glm::mat4 projection;
+  glm::mat4 view;
+  glm::vec3 eye;
+  float time;
+  glm::vec3 light_dir; // towards the light
+  float height_scale;  // parallax depth in UV units
+};
+
+// what shaders see of each object, indexed with gl_BaseInstance
+struct object_data {
+  glm::mat4 model;
+  glm::mat4 normal;      // inverse transpose of model, mat3 columns padded
+  uint32_t material = 0; // index into derp::material_table
+  uint32_t padding[3]{};
+};
+
+enum object_index : uint32_t { CUBE, MARIO, OBJECTS };
+
+template <> struct derp::block_traits<frame_data> {
+  static constexpr std::string_view name = "frame_data";
+  static constexpr std::string_view instance = "frame";
+  static constexpr uint32_t binding = 0;
+  static constexpr std::array fields{
+      DERP_BLOCK_FIELD(frame_data, projection),
+      DERP_BLOCK_FIELD(frame_data, view),
+      DERP_BLOCK_FIELD(frame_data, eye),
+      DERP_BLOCK_FIELD(frame_data, time),
+      DERP_BLOCK_FIELD(frame_data, light_dir),
+      DERP_BLOCK_FIELD(frame_data, height_scale)};
+};
+
+template <> struct derp::block_traits<object_data> {
+  static constexpr std::string_view name = "object_data";
+  static constexpr std::string_view instance = "objects";
+  static constexpr uint32_t binding = 0;
+  static constexpr std::array fields{
+      DERP_BLOCK_FIELD(object_data, model),
+      DERP_BLOCK_FIELD(object_data, normal),
+      DERP_BLOCK_FIELD(object_data, material),
+      DERP_BLOCK_FIELD(object_data, padding)};
+};
+
+// makes the block declarations includable as "frame_data.glsl",
+// "object_data.glsl", "material_data.glsl" and, for compute shaders filling
+// it in, "object_data_writable.glsl". for derp and for shader_prep alike
+inline auto add_shader_blocks(derp::glsl_preprocessor &preprocessor) -> void {
+  preprocessor.add_generated("frame_data.glsl",
+                             derp::uniform_buffer<frame_data>::glsl());
+  preprocessor.add_generated("object_data.glsl",
+                             derp::storage_buffer<object_data>::glsl());
+  preprocessor.add_generated("object_data_writable.glsl",
+                             derp::storage_buffer<object_data>::glsl(true));
+  preprocessor.add_generated(
+      "material_data.glsl", derp::storage_buffer<derp::material_data>::glsl());
+}
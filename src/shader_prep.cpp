@@ -0,0 +1,46 @@
+//===-- Offline shader preprocessor for derp ------------------------------===//
+//
+// Copyright (c) 2025 Krishna Pandey. All rights reserved.
+// SPDX-License-Identifier: MIT
+// Part of the derp project, under the MIT License.
+// See https://opensource.org/licenses/MIT for license information.
+//
+//===----------------------------------------------------------------------===//
+
+// Writes a shader with its includes pasted in, the generated block
+// declarations included, for glslangValidator to compile to SPIR-V at build
+// time. derp preprocesses the same way at run time, so both agree.
+//
+//   shader_prep <shader> <output>
+
+#include "derp/glsl_preprocessor.hpp"
+#include "shader_blocks.hpp"
+
+#include <filesystem> // std::filesystem::create_directories
+#include <fstream>    // std::ofstream
+#include <print>      // std::println
+
+int main(const int argc, const char *argv[]) {
+  if (argc != 3) {
+    std::println("[ERROR] usage: shader_prep <shader> <output>");
+    return 1;
+  }
+
+  derp::glsl_preprocessor preprocessor;
+  add_shader_blocks(preprocessor);
+  const auto processed = preprocessor.process(argv[1]);
+  if (!processed) {
+    std::println("{}", processed.error());
+    return 1;
+  }
+
+  const std::filesystem::path output = argv[2];
+  std::filesystem::create_directories(output.parent_path());
+  std::ofstream file{output, std::ios::binary};
+  if (!file.write(processed->source.data(),
+                  static_cast<std::streamsize>(processed->source.size()))) {
+    std::println("[ERROR] Couldn't write file: {}.", output.string());
+    return 1;
+  }
+  return 0;
+}